@@ -0,0 +1,400 @@
+#include <stdio.h>
+#include <float.h>
+#include <time.h>
+#include "benchmark.h"
+
+// Number of positions searched by the reports.
+#define NUM_TEST_POSITIONS 6
+
+// Test positions, given as the moves played from the start of the
+// game (black moves first). They are middle game positions of
+// usual openings.
+static const char *test_positions[NUM_TEST_POSITIONS] =
+{
+    "F5D6C3D3C4F4F6F3E6E7",
+    "F5F6E6F4E3C5C4E7B6D3",
+    "F5D6C5F4E3F6E6D3C6B5",
+    "F5F4E3F6D3E2F3C3C4B4",
+    "F5D6C4D3C3F4F6F3E6E7D7C6",
+    "F5F6E6F4G5E7F3H4D3C3C4"
+};
+
+// Number of endgame positions searched by the bench report.
+#define NUM_ENDGAME_POSITIONS 4
+
+// Endgame positions, with 20, 18, 16 and 14 empty squares, given
+// like the test positions. They come from games of the engine
+// against itself.
+static const char *endgame_positions[NUM_ENDGAME_POSITIONS] =
+{
+    "F5D6C3D3C4F4F6F3E6E7D8F8C6G5E8B3G3E3H4C7C5H3F2C8H2B4A3E2B6F7A5H5"
+    "H6C2E1F1D7A6B5D2",
+    "F5F6E6F4E3C5C4E7B6D3G4B5D2D1C1B1G6F3D7H5C2D6F2C3H4E2A5H7B4D8E8A6"
+    "C6F8H6H3E1F1A7C8C7A3",
+    "F5D6C5F4E3F6E6D3C6B5G3F7G5D7C8H4C7F3D2C4A5E8H6E2F8A6B3D1D8H3B6A4"
+    "C3G6E1H5C1A3H2B7B4C2E7F2",
+    "F5F4E3F6D3E2F3C3C4B4F1C2C5F2A4E1G4C6E6E7D1A3D6A5B3H4F7D2H5G5B5C1"
+    "G3F8B6H6G6G1B2D7E8A6B7H3D8A8"
+};
+
+// Known numbers of leaves of the game tree from the starting
+// position, for depths 1, 2, 3... (passes count as a move, and a
+// finished game counts as a leaf).
+#define NUM_START_PERFTS 13
+static const uint64_t start_perfts[NUM_START_PERFTS] =
+{
+    4, 12, 56, 244, 1396, 8200, 55092, 390216, 3005288, 24571284,
+    212258800, 1939886636, 18429641748ULL
+};
+
+// Numbers of leaves from the test positions, for depths 1 to
+// NUM_TEST_PERFTS.
+#define NUM_TEST_PERFTS 8
+static const uint64_t test_perfts[NUM_TEST_POSITIONS][NUM_TEST_PERFTS] =
+{
+    { 11, 134, 1433, 16466, 188748, 2209794, 26803455, 324544794 },
+    { 9, 82, 810, 8729, 92973, 1080591, 12218973, 149688258 },
+    { 13, 139, 1629, 16781, 201161, 2188627, 27425191, 314838286 },
+    { 10, 105, 1157, 11279, 136794, 1398943, 17828744, 193328222 },
+    { 14, 169, 2032, 24612, 299798, 3759488, 47119083, 611102682 },
+    { 6, 67, 567, 6482, 63064, 763114, 7945011, 100338821 }
+};
+
+static int print_perft(
+        const char *name, const char *moves, int depth,
+        const uint64_t references[], int num_references, double *elapsed,
+        uint64_t *leaves);
+static uint64_t perft(Position *position, int depth);
+static double get_time(void);
+static int bench_position(
+        const char *name, const char *moves, double *elapsed,
+        unsigned long *nodes, uint32_t *checksum);
+static int setup_position(
+        const char *moves, Position *position, char *is_max);
+
+
+// Measures how the search scales with the number of threads. Each
+// test position is searched for the time budget of a move with 1,
+// 2, 4... threads (up to the given number), and the total number
+// of nodes, the nodes per second and the speedup with respect to
+// one thread are printed for each number of threads.
+//
+// The transposition table is cleared before every search, so that
+// the searches don't help each other.
+void print_smp_report(const Search_options *options, int max_threads)
+{
+    double base_speed = 0;
+
+    if (max_threads > MAX_THREADS)
+        max_threads = MAX_THREADS;
+
+    printf(
+            "SMP report: %d positions, %.2f s per move, %d MB hash\n",
+            NUM_TEST_POSITIONS, options->move_time, options->hash_size);
+    printf("threads      nodes         nps  depth  speedup\n");
+
+    for (int count = 1; count <= max_threads; count *= 2)
+    {
+        unsigned long nodes = 0;
+        double elapsed = 0;
+        int depth = 0;
+
+        set_search_threads(count);
+        for (int i = 0; i < NUM_TEST_POSITIONS; i++)
+        {
+            Position position;
+            Search_result result;
+            char is_max;
+
+            if (!setup_position(test_positions[i], &position, &is_max))
+            {
+                fprintf(stderr, "Invalid test position %d.\n", i + 1);
+                return;
+            }
+
+            clear_search();
+            search_position(&position, is_max, &result);
+            nodes += result.counters.nodes;
+            elapsed += result.counters.elapsed;
+            depth += result.depth;
+        }
+
+        double speed = elapsed > 0 ? nodes / elapsed : 0;
+        if (count == 1)
+            base_speed = speed;
+        printf(
+                "%7d %10lu %11.0f %6.1f %8.2f\n",
+                count, nodes, speed, (double) depth / NUM_TEST_POSITIONS,
+                base_speed > 0 ? speed / base_speed : 0);
+    }
+
+    // Go back to the number of threads of the settings.
+    set_search_threads(options->threads);
+}
+
+
+// Searches the test positions (middle game) and the endgame
+// positions to a fixed depth, with one thread and an empty
+// transposition table every time, and prints for each one the
+// move chosen, its score, the nodes visited and the time it took
+// to reach the depth. The endgame positions that the engine solves
+// are searched to the end.
+//
+// The search is deterministic, so the total number of nodes and
+// the checksum of the moves and scores chosen must stay the same
+// after a change that only makes the search faster.
+//
+// Returns 1 on success and 0 if a position is invalid.
+int print_bench_report(const Search_options *options, int depth)
+{
+    Search_options bench_options = *options;
+    double elapsed = 0;
+    unsigned long nodes = 0;
+    uint32_t checksum = 2166136261u;
+    int valid = 1;
+
+    // Only the depth limits the search.
+    bench_options.max_depth = depth;
+    bench_options.move_time = DBL_MAX;
+    bench_options.threads = 1;
+    bench_options.ponder = FALSE;
+    set_search_options(&bench_options);
+
+    printf(
+            "Bench report: depth %d, %d positions, %d MB hash\n", depth,
+            NUM_TEST_POSITIONS + NUM_ENDGAME_POSITIONS, options->hash_size);
+    printf("position  move  score  depth      nodes     time         nps\n");
+
+    for (int i = 0; i < NUM_TEST_POSITIONS; i++)
+    {
+        char name[16];
+
+        snprintf(name, sizeof(name), "test %d", i + 1);
+        valid &= bench_position(
+                name, test_positions[i], &elapsed, &nodes, &checksum);
+    }
+    for (int i = 0; i < NUM_ENDGAME_POSITIONS; i++)
+    {
+        char name[16];
+
+        snprintf(name, sizeof(name), "endgame %d", i + 1);
+        valid &= bench_position(
+                name, endgame_positions[i], &elapsed, &nodes, &checksum);
+    }
+
+    printf(
+            "total %31lu %8.3f %11.0f\n",
+            nodes, elapsed, elapsed > 0 ? nodes / elapsed : 0);
+    printf("checksum %08x\n", checksum);
+
+    // Go back to the settings of the engine.
+    set_search_options(options);
+    return valid;
+}
+
+
+// Searches one position of the bench report and prints its line.
+//
+// Arguments:
+// The name of the position and the moves that lead to it.
+// The total time, number of nodes and checksum so far, which are
+// updated.
+//
+// Returns 1 on success and 0 if the position is invalid.
+static int bench_position(
+        const char *name, const char *moves, double *elapsed,
+        unsigned long *nodes, uint32_t *checksum)
+{
+    Position position;
+    Search_result result;
+    char is_max;
+
+    if (!setup_position(moves, &position, &is_max))
+    {
+        printf("%-9s invalid position\n", name);
+        return 0;
+    }
+
+    clear_search();
+    search_position(&position, is_max, &result);
+
+    const Search_counters *counters = &result.counters;
+    *elapsed += counters->elapsed;
+    *nodes += counters->nodes;
+
+    // FNV-1a hash of the moves and scores.
+    *checksum = (*checksum ^ (uint32_t) result.square) * 16777619u;
+    *checksum = (*checksum ^ (uint32_t) result.score) * 16777619u;
+
+    printf(
+            "%-9s   %c%c %6d %6d %10lu %8.3f %11.0f\n",
+            name, 'A' + result.square % BOARD_WIDTH,
+            '1' + result.square / BOARD_WIDTH, result.score, result.depth,
+            counters->nodes, counters->elapsed,
+            counters->elapsed > 0 ? counters->nodes / counters->elapsed : 0);
+    return 1;
+}
+
+
+// Counts the leaves of the game tree to the given depth from the
+// starting position and from every test position, and prints the
+// counts, the speed of the move generator (leaves per second) and
+// whether the counts are the known ones.
+//
+// Returns 1 if every count that is known is right, and 0
+// otherwise.
+int print_perft_report(int depth)
+{
+    int passed = 1;
+    double elapsed = 0;
+    uint64_t leaves = 0;
+
+    printf("Perft report: depth %d\n", depth);
+    printf("position      leaves         nps  result\n");
+
+    passed &= print_perft(
+            "start", "", depth, start_perfts, NUM_START_PERFTS,
+            &elapsed, &leaves);
+    for (int i = 0; i < NUM_TEST_POSITIONS; i++)
+    {
+        char name[16];
+
+        snprintf(name, sizeof(name), "test %d", i + 1);
+        passed &= print_perft(
+                name, test_positions[i], depth, test_perfts[i],
+                NUM_TEST_PERFTS, &elapsed, &leaves);
+    }
+    printf(
+            "total    %11llu %11.0f  %s\n",
+            (unsigned long long) leaves,
+            elapsed > 0 ? leaves / elapsed : 0, passed ? "ok" : "WRONG");
+    return passed;
+}
+
+
+// Runs perft on one position and prints a line of the report.
+//
+// Arguments:
+// The name of the position and the moves that lead to it.
+// The depth.
+// The known counts of the position, for depths 1, 2, 3...
+// The total time and number of leaves so far, which are updated.
+//
+// Returns 0 if the count is wrong, and 1 if it's right or it isn't
+// known.
+static int print_perft(
+        const char *name, const char *moves, int depth,
+        const uint64_t references[], int num_references, double *elapsed,
+        uint64_t *leaves)
+{
+    Position position;
+    char is_max;
+
+    if (!setup_position(moves, &position, &is_max))
+    {
+        printf("%-8s invalid position\n", name);
+        return 0;
+    }
+
+    double start = get_time();
+    uint64_t count = perft(&position, depth);
+    double time = get_time() - start;
+
+    *elapsed += time;
+    *leaves += count;
+
+    int known = depth >= 1 && depth <= num_references;
+    int right = !known || count == references[depth - 1];
+    printf(
+            "%-8s %11llu %11.0f  %s\n",
+            name, (unsigned long long) count, time > 0 ? count / time : 0,
+            !known ? "unknown" : right ? "ok" : "WRONG");
+    return right;
+}
+
+
+// Counts the leaves of the game tree to the given depth. A pass
+// counts as a move, and a finished game is a leaf.
+//
+// At the last ply the moves are counted instead of played.
+static uint64_t perft(Position *position, int depth)
+{
+    if (depth == 0)
+        return 1;
+
+    Bitboard moves = get_valid_moves(position);
+
+    // The side to move passes, unless the game is over.
+    if (!moves)
+    {
+        Position passed = *position;
+
+        pass_turn(&passed);
+        if (!get_valid_moves(&passed))
+            return 1;
+        return perft(&passed, depth - 1);
+    }
+
+    if (depth == 1)
+        return count_discs(moves);
+
+    uint64_t leaves = 0;
+    while (moves)
+    {
+        int square = pop_first_square(&moves);
+        Bitboard flipped = play_move(position, square);
+
+        leaves += perft(position, depth - 1);
+        undo_move(position, square, flipped);
+    }
+    return leaves;
+}
+
+
+// Returns the time elapsed since an arbitrary point, in seconds.
+static double get_time(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+
+// Plays the given moves (like "F5D6") from the start of the game.
+// A player without valid moves passes.
+//
+// Arguments:
+// The moves.
+// A position to store the result, and whether the side to move is
+// the maximizer (white).
+//
+// Returns 1 on success and 0 if a move is not valid.
+static int setup_position(
+        const char *moves, Position *position, char *is_max)
+{
+    set_start_position(position);
+    *is_max = 0;
+
+    for (int i = 0; moves[i] && moves[i + 1]; i += 2)
+    {
+        int column = moves[i] - 'A';
+        int row = moves[i + 1] - '1';
+        int square = row * BOARD_WIDTH + column;
+
+        if (!get_valid_moves(position))
+        {
+            pass_turn(position);
+            *is_max = !*is_max;
+        }
+        if (
+                column < 0 || column >= BOARD_WIDTH ||
+                row < 0 || row >= BOARD_WIDTH ||
+                !(get_valid_moves(position) & SQUARE_BIT(square)))
+            return 0;
+
+        play_move(position, square);
+        *is_max = !*is_max;
+    }
+    return 1;
+}
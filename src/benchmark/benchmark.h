@@ -0,0 +1,13 @@
+#ifndef _BENCHMARK_
+#define _BENCHMARK_
+
+#include "../minimax/minimax.h"
+
+// Depth of the bench report, unless another one is given.
+#define DEFAULT_BENCH_DEPTH 10
+
+void print_smp_report(const Search_options *options, int max_threads);
+int print_perft_report(int depth);
+int print_bench_report(const Search_options *options, int depth);
+
+#endif
@@ -0,0 +1,229 @@
+#include "bitboard.h"
+
+// Row and column offsets for each of the eight directions, in the
+// same order as the ray table.
+static const int row_offsets[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+static const int column_offsets[8] = { 1, -1, 0, 1, -1, 1, 0, -1 };
+
+// Squares that are not on the A or H columns.
+#define INNER_COLUMNS 0x7e7e7e7e7e7e7e7eULL
+
+// Squares that are not on the A column, and not on the H column.
+#define NOT_COLUMN_A 0xfefefefefefefefeULL
+#define NOT_COLUMN_H 0x7f7f7f7f7f7f7f7fULL
+
+// Squares reached from each square going along each direction, up
+// to the edge of the board. The first four directions go towards
+// higher squares (east, south west, south, south east) and the
+// last four towards lower squares.
+static Bitboard rays[8][NUM_SQUARES];
+
+static Bitboard get_moves_in_direction(
+        Bitboard player, Bitboard opponent, int shift);
+static int is_inside_board(int i, int j);
+
+
+// Fills the ray table. Must be called once before using any of
+// the other functions of this module.
+void init_bitboard(void)
+{
+    for (int square = 0; square < NUM_SQUARES; square++)
+    {
+        for (int dir = 0; dir < 8; dir++)
+        {
+            int i = square / BOARD_WIDTH + row_offsets[dir];
+            int j = square % BOARD_WIDTH + column_offsets[dir];
+
+            rays[dir][square] = 0;
+            while (is_inside_board(i, j))
+            {
+                rays[dir][square] |= SQUARE_BIT(i * BOARD_WIDTH + j);
+                i += row_offsets[dir];
+                j += column_offsets[dir];
+            }
+        }
+    }
+}
+
+
+// Sets a position to the start of the game, with black to move
+// (black on D5 and E4, white on D4 and E5).
+void set_start_position(Position *position)
+{
+    position->player =
+        SQUARE_BIT(3 * BOARD_WIDTH + 4) | SQUARE_BIT(4 * BOARD_WIDTH + 3);
+    position->opponent =
+        SQUARE_BIT(3 * BOARD_WIDTH + 3) | SQUARE_BIT(4 * BOARD_WIDTH + 4);
+}
+
+
+// Returns the set of squares where the side to move can play.
+//
+// The moves are generated for all the squares at once: the
+// player's discs are shifted over runs of opponent's discs in
+// each of the eight directions (Kogge-Stone fill), and the empty
+// squares right after those runs are the valid moves.
+Bitboard get_valid_moves(const Position *position)
+{
+    Bitboard empty_squares = ~(position->player | position->opponent);
+
+    // Opponent's discs that can be flanked horizontally and
+    // diagonally, without wrapping around the edges of the board.
+    Bitboard inner = position->opponent & INNER_COLUMNS;
+
+    Bitboard moves =
+        get_moves_in_direction(position->player, inner, 1) |
+        get_moves_in_direction(position->player, position->opponent, 8) |
+        get_moves_in_direction(position->player, inner, 7) |
+        get_moves_in_direction(position->player, inner, 9);
+
+    return moves & empty_squares;
+}
+
+
+// Returns the squares right after the runs of opponent's discs
+// that start next to one of the player's discs, going both ways
+// along a direction (given by its shift).
+//
+// The longest possible run has six discs, so the fill is done in
+// four steps: one disc, one more, and two pairs of discs.
+static Bitboard get_moves_in_direction(
+        Bitboard player, Bitboard opponent, int shift)
+{
+    // Going towards higher squares.
+    Bitboard flipped = opponent & (player << shift);
+    flipped |= opponent & (flipped << shift);
+    Bitboard pairs = opponent & (opponent << shift);
+    flipped |= pairs & (flipped << (2 * shift));
+    flipped |= pairs & (flipped << (2 * shift));
+    Bitboard moves = flipped << shift;
+
+    // Going towards lower squares.
+    flipped = opponent & (player >> shift);
+    flipped |= opponent & (flipped >> shift);
+    pairs = opponent & (opponent >> shift);
+    flipped |= pairs & (flipped >> (2 * shift));
+    flipped |= pairs & (flipped >> (2 * shift));
+    moves |= flipped >> shift;
+
+    return moves;
+}
+
+
+// Returns the set of discs that would be flipped if the side to
+// move played on the given (empty) square.
+//
+// Each of the eight rays leaving the square is looked up in the
+// ray table. The first square along the ray that doesn't hold an
+// opponent's disc closes the line: if it holds one of the player's
+// discs, every square before it on the ray is flipped.
+Bitboard get_flipped_discs(const Position *position, int square)
+{
+    Bitboard flipped = 0;
+
+    // Rays going towards higher squares: the closing square is
+    // the lowest one.
+    for (int dir = 0; dir < 4; dir++)
+    {
+        Bitboard ray = rays[dir][square];
+        Bitboard closing = ray & ~position->opponent;
+        closing &= -closing;
+
+        // All ones if the line is closed by a player's disc,
+        // zero otherwise.
+        Bitboard closed = -(Bitboard) ((closing & position->player) != 0);
+        flipped |= ray & (closing - 1) & closed;
+    }
+
+    // Rays going towards lower squares: the closing square is
+    // the highest one. The extra bit keeps the count of leading
+    // zeros defined, and is never on one of these rays when the
+    // ray has no closing square.
+    for (int dir = 4; dir < 8; dir++)
+    {
+        Bitboard ray = rays[dir][square];
+        Bitboard closing = (ray & ~position->opponent) | 1;
+        closing = SQUARE_BIT(63 - __builtin_clzll(closing)) & ray;
+
+        Bitboard closed = -(Bitboard) ((closing & position->player) != 0);
+        flipped |= ray & ~((closing << 1) - 1) & closed;
+    }
+    return flipped;
+}
+
+
+// Plays the side to move on the given square and hands the turn
+// over to the opponent.
+//
+// Returns the discs that were flipped, which undo_move() needs to
+// take the move back.
+Bitboard play_move(Position *position, int square)
+{
+    Bitboard flipped = get_flipped_discs(position, square);
+    Bitboard player = position->player ^ (flipped | SQUARE_BIT(square));
+
+    position->player = position->opponent ^ flipped;
+    position->opponent = player;
+    return flipped;
+}
+
+
+// Takes back a move made with play_move(), given the square where
+// it was played and the discs it flipped.
+void undo_move(Position *position, int square, Bitboard flipped)
+{
+    Bitboard player = position->opponent ^ (flipped | SQUARE_BIT(square));
+
+    position->opponent = position->player ^ flipped;
+    position->player = player;
+}
+
+
+// Returns the squares next to (in any of the eight directions)
+// the squares of a set.
+Bitboard get_neighbours(Bitboard squares)
+{
+    Bitboard neighbours = (squares << 8) | (squares >> 8);
+
+    // Moving one column to the right can't end on the A column,
+    // and one column to the left can't end on the H column.
+    neighbours |=
+        ((squares << 1) | (squares << 9) | (squares >> 7)) & NOT_COLUMN_A;
+    neighbours |=
+        ((squares >> 1) | (squares >> 9) | (squares << 7)) & NOT_COLUMN_H;
+    return neighbours;
+}
+
+
+// Hands the turn over to the opponent without playing.
+void pass_turn(Position *position)
+{
+    Bitboard player = position->player;
+
+    position->player = position->opponent;
+    position->opponent = player;
+}
+
+
+// Returns the number of discs in a set.
+int count_discs(Bitboard discs)
+{
+    return __builtin_popcountll(discs);
+}
+
+
+// Removes the lowest square from a set and returns its index.
+// The set must not be empty.
+int pop_first_square(Bitboard *squares)
+{
+    int square = __builtin_ctzll(*squares);
+
+    *squares &= *squares - 1;
+    return square;
+}
+
+
+static int is_inside_board(int i, int j)
+{
+    return i >= 0 && i < BOARD_WIDTH && j >= 0 && j < BOARD_WIDTH;
+}
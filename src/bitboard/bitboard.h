@@ -0,0 +1,51 @@
+#ifndef _BITBOARD_
+#define _BITBOARD_
+
+#include <stdint.h>
+
+// Width of the board, in squares.
+#define BOARD_WIDTH 8
+
+// Number of squares on the board.
+#define NUM_SQUARES 64
+
+// Boolean values. The engine doesn't depend on GLib, so it defines
+// them the same way when GLib isn't included.
+#ifndef FALSE
+#define FALSE (0)
+#endif
+#ifndef TRUE
+#define TRUE (!FALSE)
+#endif
+
+// Set of squares of the board. Bit (row * BOARD_WIDTH + column)
+// represents the square on that row and column, so bit 0 is A1
+// and bit 63 is H8.
+typedef uint64_t Bitboard;
+
+// Compact representation of a position used by the search engine.
+//
+// The discs are stored relative to the side to move, which makes
+// the struct only 16 bytes long. The color of the side to move is
+// not stored: the search keeps track of it (see minimax.c).
+typedef struct Position
+{
+    Bitboard player;
+    Bitboard opponent;
+} Position;
+
+// Returns the bitboard with only the given square set.
+#define SQUARE_BIT(square) ((Bitboard) 1 << (square))
+
+void init_bitboard(void);
+void set_start_position(Position *position);
+Bitboard get_valid_moves(const Position *position);
+Bitboard get_flipped_discs(const Position *position, int square);
+Bitboard play_move(Position *position, int square);
+void undo_move(Position *position, int square, Bitboard flipped);
+void pass_turn(Position *position);
+Bitboard get_neighbours(Bitboard squares);
+int count_discs(Bitboard discs);
+int pop_first_square(Bitboard *squares);
+
+#endif
@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include "archive.h"
+
+
+// Replays a game written as the moves played from the start (like
+// "F5D6C3D3C4..."), with black moving first and passes left out.
+//
+// Returns 1 if every move is valid and 0 otherwise.
+int replay_game(const char *moves, Archive_game *game)
+{
+    Position position;
+    char white_to_move = FALSE;
+
+    set_start_position(&position);
+    game->num_plies = 0;
+    for (int i = 0; isalpha((unsigned char) moves[i]); i += 2)
+    {
+        int column = toupper((unsigned char) moves[i]) - 'A';
+        int row = moves[i + 1] - '1';
+        int square = row * BOARD_WIDTH + column;
+
+        // A player without valid moves passes.
+        if (!get_valid_moves(&position))
+        {
+            pass_turn(&position);
+            white_to_move = !white_to_move;
+        }
+        if (
+                game->num_plies == NUM_SQUARES ||
+                column < 0 || column >= BOARD_WIDTH ||
+                row < 0 || row >= BOARD_WIDTH ||
+                !(get_valid_moves(&position) & SQUARE_BIT(square)))
+            return 0;
+
+        game->positions[game->num_plies] = position;
+        game->white_to_move[game->num_plies] = white_to_move;
+        game->squares[game->num_plies] = square;
+        game->num_plies++;
+
+        play_move(&position, square);
+        white_to_move = !white_to_move;
+    }
+
+    // The game is over when neither side can move.
+    Position opponent = { position.opponent, position.player };
+    game->complete =
+        !get_valid_moves(&position) && !get_valid_moves(&opponent);
+
+    int score = count_discs(position.player) - count_discs(position.opponent);
+    game->black_score = white_to_move ? -score : score;
+    return 1;
+}
+
+
+// Reads every game of an archive and gives it to the callback.
+//
+// Every line of an archive is a game (see replay_game()). Empty
+// lines and lines starting with '#' are skipped, and so are the
+// games that aren't valid or that the callback doesn't take, with a
+// message.
+//
+// Returns the number of games taken, or -1 if the file couldn't be
+// opened or there wasn't enough memory.
+int read_archive(const char *path, Archive_callback callback, void *data)
+{
+    static Archive_game game;
+    FILE *fp = fopen(path, "r");
+    char line[MAX_LINE_LENGTH];
+    int line_number = 0;
+    int num_games = 0;
+
+    if (!fp)
+    {
+        fprintf(stderr, "Could not open %s.\n", path);
+        return -1;
+    }
+
+    while (fgets(line, MAX_LINE_LENGTH, fp))
+    {
+        line_number++;
+        if (line[0] == '#' || isspace((unsigned char) line[0]))
+            continue;
+
+        if (!replay_game(line, &game))
+        {
+            fprintf(
+                    stderr, "%s:%d: not a valid game, skipped.\n",
+                    path, line_number);
+            continue;
+        }
+
+        int result = callback(&game, data);
+        if (result < 0)
+        {
+            fprintf(stderr, "Out of memory.\n");
+            fclose(fp);
+            return -1;
+        }
+        else if (result == 0)
+            fprintf(
+                    stderr, "%s:%d: not a complete game, skipped.\n",
+                    path, line_number);
+        else
+            num_games++;
+    }
+    fclose(fp);
+    return num_games;
+}
+
+
+// Appends a position to the list.
+//
+// Arguments:
+// The list.
+// The position, relative to the side to move.
+// Whether white is to move.
+// The final disc difference for black.
+//
+// Returns 1 on success and 0 if there wasn't enough memory.
+int add_game_position(
+        Position_list *list, const Position *position, char white_to_move,
+        int score)
+{
+    if (list->num_positions == list->capacity)
+    {
+        size_t capacity = list->capacity ? 2 * list->capacity : 1024;
+        Game_position *positions =
+            realloc(list->positions, capacity * sizeof(Game_position));
+
+        if (!positions)
+            return 0;
+        list->positions = positions;
+        list->capacity = capacity;
+    }
+
+    Game_position *game_position = &list->positions[list->num_positions++];
+    game_position->black =
+        white_to_move ? position->opponent : position->player;
+    game_position->white =
+        white_to_move ? position->player : position->opponent;
+    game_position->white_to_move = white_to_move;
+    game_position->score = score;
+    return 1;
+}
+
+
+// Archive callback of the trainers: adds to a Position_list the
+// positions of a complete game, each one with the final disc
+// difference for black. The start is left out, since it's the same
+// in every game.
+int add_scored_positions(const Archive_game *game, void *list)
+{
+    if (!game->complete)
+        return 0;
+
+    for (int i = 1; i < game->num_plies; i++)
+    {
+        if (!add_game_position(
+                    list, &game->positions[i], game->white_to_move[i],
+                    game->black_score))
+            return -1;
+    }
+    return 1;
+}
+
+
+// Puts the positions in random order.
+void shuffle_game_positions(Game_position positions[], size_t num_positions)
+{
+    for (size_t i = num_positions; i > 1; i--)
+    {
+        // rand() alone may not reach every index of a long list.
+        size_t j =
+            ((size_t) rand() * ((size_t) RAND_MAX + 1) + rand()) % i;
+        Game_position swap = positions[i - 1];
+
+        positions[i - 1] = positions[j];
+        positions[j] = swap;
+    }
+}
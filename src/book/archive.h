@@ -0,0 +1,57 @@
+#ifndef _ARCHIVE_
+#define _ARCHIVE_
+
+#include <stddef.h>
+#include "../bitboard/bitboard.h"
+
+// Maximum length of a line of the game archives.
+#define MAX_LINE_LENGTH 1024
+
+// A game of an archive, replayed from the start. For every move,
+// the position before it (relative to the side to move, after any
+// pass), the color that made it and its square.
+typedef struct Archive_game
+{
+    Position positions[NUM_SQUARES];
+    char white_to_move[NUM_SQUARES];
+    int squares[NUM_SQUARES];
+    int num_plies;
+
+    // Whether the game is over after the last move, and then the
+    // final disc difference for black.
+    char complete;
+    int black_score;
+} Archive_game;
+
+// A position of a game by color, the side to move, and how many
+// discs black won the game by.
+typedef struct Game_position
+{
+    Bitboard black;
+    Bitboard white;
+    char white_to_move;
+    int score;
+} Game_position;
+
+// Positions collected from the games.
+typedef struct Position_list
+{
+    Game_position *positions;
+    size_t num_positions;
+    size_t capacity;
+} Position_list;
+
+// What the tools do with every game of an archive. Returns 1 if the
+// game was taken, 0 if it was skipped because it isn't complete and
+// -1 if there wasn't enough memory.
+typedef int (*Archive_callback)(const Archive_game *game, void *data);
+
+int replay_game(const char *moves, Archive_game *game);
+int read_archive(const char *path, Archive_callback callback, void *data);
+int add_game_position(
+        Position_list *list, const Position *position, char white_to_move,
+        int score);
+int add_scored_positions(const Archive_game *game, void *list);
+void shuffle_game_positions(Game_position positions[], size_t num_positions);
+
+#endif
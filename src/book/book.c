@@ -0,0 +1,265 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "book.h"
+#include "../minimax/transposition.h"
+
+static int transform_square(int square, int symmetry);
+static Bitboard flip_vertical(Bitboard squares);
+static Bitboard mirror_horizontal(Bitboard squares);
+static Bitboard transpose(Bitboard squares);
+
+
+// Maps a book file in memory.
+//
+// Returns 1 on success and 0 if the file couldn't be opened or
+// isn't a valid book.
+int open_book(Book *book, const char *path)
+{
+    struct stat file_status;
+    int file = open(path, O_RDONLY);
+
+    if (file < 0)
+        return 0;
+    if (
+            fstat(file, &file_status) < 0 ||
+            (size_t) file_status.st_size < sizeof(Book_header))
+    {
+        close(file);
+        return 0;
+    }
+
+    size_t size = file_status.st_size;
+    void *data = mmap(NULL, size, PROT_READ, MAP_SHARED, file, 0);
+
+    // The mapping stays valid after the file is closed.
+    close(file);
+    if (data == MAP_FAILED)
+        return 0;
+
+    // Check that the header is right and the file has every entry.
+    const Book_header *header = data;
+    if (
+            header->magic != BOOK_MAGIC ||
+            header->version != BOOK_VERSION ||
+            header->num_entries >
+            (size - sizeof(Book_header)) / sizeof(Book_entry))
+    {
+        munmap(data, size);
+        return 0;
+    }
+
+    book->data = data;
+    book->size = size;
+    book->entries = (const Book_entry *) (header + 1);
+    book->num_entries = header->num_entries;
+    return 1;
+}
+
+
+void close_book(Book *book)
+{
+    if (book->data)
+        munmap((void *) book->data, book->size);
+    book->data = NULL;
+    book->entries = NULL;
+    book->size = 0;
+    book->num_entries = 0;
+}
+
+
+// Looks for the position in the book.
+//
+// Of the moves played in the position often enough, the one with
+// the best average result is chosen.
+//
+// Arguments:
+// The book.
+// The position, relative to the side to move.
+// A variable to store the square of the move.
+//
+// Returns 1 if a move was found and 0 if it wasn't.
+int probe_book(const Book *book, const Position *position, int *square)
+{
+    unsigned symmetries;
+    uint64_t key = normalize_position(position, &symmetries);
+
+    // Binary search of the first entry of the position.
+    size_t low = 0;
+    size_t high = book->num_entries;
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (book->entries[middle].key < key)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    // Choose among the moves of the position.
+    const Book_entry *best_entry = NULL;
+    for (
+            const Book_entry *entry = &book->entries[low];
+            entry < book->entries + book->num_entries && entry->key == key;
+            entry++)
+    {
+        if (entry->games < BOOK_MIN_GAMES)
+            continue;
+
+        // Compare the average scores (score / games) without
+        // dividing.
+        if (
+                !best_entry ||
+                (int64_t) entry->score * best_entry->games >
+                (int64_t) best_entry->score * entry->games)
+            best_entry = entry;
+    }
+    if (!best_entry)
+        return 0;
+
+    // The move is stored for the normalized position. Any of the
+    // symmetries that normalize the position takes a square of the
+    // real board to it.
+    int symmetry = __builtin_ctz(symmetries);
+    for (int i = 0; i < NUM_SQUARES; i++)
+    {
+        if (transform_square(i, symmetry) == best_entry->move)
+        {
+            // Two positions with the same key are very unlikely,
+            // but make sure the move can be played.
+            if (!(get_valid_moves(position) & SQUARE_BIT(i)))
+                return 0;
+            *square = i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+// Computes the key of a position that is the same for the eight
+// rotations and reflections of the position: the lowest of their
+// Zobrist keys.
+//
+// Arguments:
+// The position, relative to the side to move.
+// A variable to store the set of symmetries (one bit for each)
+// that turn the position into its normalized form.
+uint64_t normalize_position(const Position *position, unsigned *symmetries)
+{
+    uint64_t normalized_key = 0;
+
+    *symmetries = 0;
+    for (int symmetry = 0; symmetry < NUM_SYMMETRIES; symmetry++)
+    {
+        Position transformed =
+        {
+            transform_bitboard(position->player, symmetry),
+            transform_bitboard(position->opponent, symmetry)
+        };
+        uint64_t key = hash_position(&transformed, 1);
+
+        if (!*symmetries || key < normalized_key)
+        {
+            normalized_key = key;
+            *symmetries = 1u << symmetry;
+        }
+        else if (key == normalized_key)
+            *symmetries |= 1u << symmetry;
+    }
+    return normalized_key;
+}
+
+
+// Returns the square of a move in the normalized form of its
+// position, given the symmetries found by normalize_position().
+//
+// When the position is symmetrical, equivalent moves (like the
+// four first moves of the game) become the same square.
+int normalize_move(unsigned symmetries, int square)
+{
+    int normalized_square = NUM_SQUARES;
+
+    for (int symmetry = 0; symmetry < NUM_SYMMETRIES; symmetry++)
+    {
+        if (symmetries & (1u << symmetry))
+        {
+            int transformed = transform_square(square, symmetry);
+            if (transformed < normalized_square)
+                normalized_square = transformed;
+        }
+    }
+    return normalized_square;
+}
+
+
+// Applies one of the eight symmetries to a set of squares: bit 2
+// of the symmetry transposes the board (over the A1-H8 diagonal),
+// then bit 1 flips it vertically and bit 0 mirrors it horizontally.
+Bitboard transform_bitboard(Bitboard squares, int symmetry)
+{
+    if (symmetry & 4)
+        squares = transpose(squares);
+    if (symmetry & 2)
+        squares = flip_vertical(squares);
+    if (symmetry & 1)
+        squares = mirror_horizontal(squares);
+    return squares;
+}
+
+
+// Same as transform_bitboard(), for a single square.
+static int transform_square(int square, int symmetry)
+{
+    int row = square / BOARD_WIDTH;
+    int column = square % BOARD_WIDTH;
+
+    if (symmetry & 4)
+    {
+        int aux = row;
+        row = column;
+        column = aux;
+    }
+    if (symmetry & 2)
+        row = BOARD_WIDTH - 1 - row;
+    if (symmetry & 1)
+        column = BOARD_WIDTH - 1 - column;
+    return row * BOARD_WIDTH + column;
+}
+
+
+// Reverses the order of the rows.
+static Bitboard flip_vertical(Bitboard squares)
+{
+    return __builtin_bswap64(squares);
+}
+
+
+// Reverses the order of the columns.
+static Bitboard mirror_horizontal(Bitboard squares)
+{
+    squares = ((squares >> 1) & 0x5555555555555555ULL) |
+        ((squares & 0x5555555555555555ULL) << 1);
+    squares = ((squares >> 2) & 0x3333333333333333ULL) |
+        ((squares & 0x3333333333333333ULL) << 2);
+    squares = ((squares >> 4) & 0x0f0f0f0f0f0f0f0fULL) |
+        ((squares & 0x0f0f0f0f0f0f0f0fULL) << 4);
+    return squares;
+}
+
+
+// Swaps rows and columns, by swapping blocks of squares across
+// the diagonal: 4x4 blocks first, then 2x2, then single squares.
+static Bitboard transpose(Bitboard squares)
+{
+    Bitboard swapped;
+
+    swapped = 0x0f0f0f0f00000000ULL & (squares ^ (squares << 28));
+    squares ^= swapped ^ (swapped >> 28);
+    swapped = 0x3333000033330000ULL & (squares ^ (squares << 14));
+    squares ^= swapped ^ (swapped >> 14);
+    swapped = 0x5500550055005500ULL & (squares ^ (squares << 7));
+    squares ^= swapped ^ (swapped >> 7);
+    return squares;
+}
@@ -0,0 +1,64 @@
+#ifndef _BOOK_
+#define _BOOK_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../bitboard/bitboard.h"
+
+// Identifies the files of opening books ("RVBK"), and the version
+// of their format.
+#define BOOK_MAGIC 0x4b425652
+#define BOOK_VERSION 1
+
+// Moves played fewer times than this are not taken from the book.
+#define BOOK_MIN_GAMES 2
+
+// Number of symmetries of the board (rotations and reflections).
+#define NUM_SYMMETRIES 8
+
+// Header at the beginning of a book file. It is followed by the
+// entries, sorted by key and then by move.
+typedef struct Book_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t num_entries;
+} Book_header;
+
+// A move played in a position, and how the games that played it
+// ended. Positions are stored in their normalized form (see
+// normalize_position()), so the move is a square of that form.
+typedef struct Book_entry
+{
+    // Zobrist key of the normalized position.
+    uint64_t key;
+
+    // Sum of the final disc differences of the games, for the
+    // player who made the move.
+    int32_t score;
+
+    // Number of games that played the move.
+    uint16_t games;
+
+    uint8_t move;
+    uint8_t reserved;
+} Book_entry;
+
+// An opening book mapped in memory. The entries are read straight
+// from the file, without copying them.
+typedef struct Book
+{
+    const void *data;
+    size_t size;
+    const Book_entry *entries;
+    size_t num_entries;
+} Book;
+
+int open_book(Book *book, const char *path);
+void close_book(Book *book);
+int probe_book(const Book *book, const Position *position, int *square);
+uint64_t normalize_position(const Position *position, unsigned *symmetries);
+int normalize_move(unsigned symmetries, int square);
+Bitboard transform_bitboard(Bitboard squares, int symmetry);
+
+#endif
@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "archive.h"
+#include "book.h"
+#include "../minimax/transposition.h"
+
+// Default number of moves of every game that go into the book.
+#define DEFAULT_MAX_PLIES 20
+
+// Entries collected from the games, before sorting them, and how
+// many moves of every game go into them.
+typedef struct Entry_list
+{
+    Book_entry *entries;
+    size_t num_entries;
+    size_t capacity;
+    int max_plies;
+} Entry_list;
+
+static int add_game(const Archive_game *game, void *list);
+static int add_entry(Entry_list *list, uint64_t key, int move, int score);
+static int compare_entries(const void *a, const void *b);
+static size_t merge_entries(Book_entry entries[], size_t num_entries);
+static int write_book(
+        const char *path, const Book_entry entries[], size_t num_entries);
+
+
+// Builds an opening book from archives of games.
+//
+// Every line of an archive is a complete game, written as the
+// moves played from the start (like "F5D6C3D3C4..."), with black
+// moving first and passes left out. Empty lines and lines starting
+// with '#' are skipped (see read_archive()).
+//
+// Usage: book_builder [--max-plies=N] BOOK ARCHIVE...
+int main(int argc, char **argv)
+{
+    Entry_list list = { NULL, 0, 0, DEFAULT_MAX_PLIES };
+    int first_file = 1;
+    int num_games = 0;
+
+    if (
+            argc > 1 &&
+            sscanf(argv[1], "--max-plies=%d", &list.max_plies) == 1)
+        first_file = 2;
+    if (argc - first_file < 2 || list.max_plies <= 0)
+    {
+        fprintf(
+                stderr,
+                "Usage: %s [--max-plies=N] BOOK ARCHIVE...\n", argv[0]);
+        return 1;
+    }
+
+    init_bitboard();
+    init_zobrist_keys();
+
+    // Read every game of every archive.
+    for (int i = first_file + 1; i < argc; i++)
+    {
+        int result = read_archive(argv[i], add_game, &list);
+
+        if (result < 0)
+            return 1;
+        num_games += result;
+    }
+
+    // Sort the entries and merge the ones of the same move.
+    qsort(list.entries, list.num_entries, sizeof(Book_entry), compare_entries);
+    size_t num_entries = merge_entries(list.entries, list.num_entries);
+
+    if (!write_book(argv[first_file], list.entries, num_entries))
+    {
+        fprintf(stderr, "Could not write %s.\n", argv[first_file]);
+        return 1;
+    }
+    printf(
+            "%d games, %zu book moves written to %s.\n",
+            num_games, num_entries, argv[first_file]);
+
+    free(list.entries);
+    return 0;
+}
+
+
+// Archive callback: adds the first moves of a complete game to an
+// Entry_list, each one with the final disc difference for the
+// player who made it.
+static int add_game(const Archive_game *game, void *list)
+{
+    Entry_list *entry_list = list;
+
+    if (!game->complete)
+        return 0;
+
+    for (int i = 0; i < game->num_plies && i < entry_list->max_plies; i++)
+    {
+        unsigned symmetries;
+        uint64_t key = normalize_position(&game->positions[i], &symmetries);
+        int square = normalize_move(symmetries, game->squares[i]);
+        int score =
+            game->white_to_move[i] ? -game->black_score : game->black_score;
+
+        if (!add_entry(entry_list, key, square, score))
+            return -1;
+    }
+    return 1;
+}
+
+
+// Appends an entry for one game to the list.
+//
+// Returns 1 on success and 0 if there wasn't enough memory.
+static int add_entry(Entry_list *list, uint64_t key, int move, int score)
+{
+    if (list->num_entries == list->capacity)
+    {
+        size_t capacity = list->capacity ? 2 * list->capacity : 1024;
+        Book_entry *entries =
+            realloc(list->entries, capacity * sizeof(Book_entry));
+
+        if (!entries)
+            return 0;
+        list->entries = entries;
+        list->capacity = capacity;
+    }
+
+    Book_entry *entry = &list->entries[list->num_entries++];
+    memset(entry, 0, sizeof(Book_entry));
+    entry->key = key;
+    entry->move = move;
+    entry->score = score;
+    entry->games = 1;
+    return 1;
+}
+
+
+// Orders entries by key, and then by move.
+static int compare_entries(const void *a, const void *b)
+{
+    const Book_entry *entry_a = a;
+    const Book_entry *entry_b = b;
+
+    if (entry_a->key != entry_b->key)
+        return entry_a->key < entry_b->key ? -1 : 1;
+    return entry_a->move - entry_b->move;
+}
+
+
+// Merges the entries of the same key and move (which must be next
+// to each other) into one.
+//
+// Returns the number of entries left.
+static size_t merge_entries(Book_entry entries[], size_t num_entries)
+{
+    size_t num_merged = 0;
+
+    for (size_t i = 0; i < num_entries; i++)
+    {
+        Book_entry *last = num_merged > 0 ? &entries[num_merged - 1] : NULL;
+
+        if (
+                last && last->key == entries[i].key &&
+                last->move == entries[i].move &&
+                last->games < UINT16_MAX)
+        {
+            last->games++;
+            last->score += entries[i].score;
+        }
+        else
+            entries[num_merged++] = entries[i];
+    }
+    return num_merged;
+}
+
+
+// Writes the header and the (sorted) entries of a book.
+//
+// Returns 1 on success and 0 on failure.
+static int write_book(
+        const char *path, const Book_entry entries[], size_t num_entries)
+{
+    Book_header header = { BOOK_MAGIC, BOOK_VERSION, num_entries };
+    FILE *fp = fopen(path, "wb");
+
+    if (!fp)
+        return 0;
+
+    int success =
+        fwrite(&header, sizeof(Book_header), 1, fp) == 1 &&
+        fwrite(entries, sizeof(Book_entry), num_entries, fp) == num_entries;
+    return fclose(fp) == 0 && success;
+}
@@ -90,6 +90,22 @@ typedef struct Game
     Players_color players_color;
     GtkBuilder *builder;
     GtkWidget *drawing_area;
+
+    // Whether the CPU is choosing a move (on a thread of its own).
+    gboolean cpu_thinking;
+
+    // Number of the game being played, so that a CPU move chosen
+    // for an earlier game isn't played on this one.
+    guint game_number;
+
+    // Number of discs of each color, and number of squares marked
+    // as valid moves. They are kept up to date by reset_board(),
+    // transform_board() and mark_valid_moves(), so the score and
+    // whether there are valid moves are known without going over
+    // the board.
+    int white_count;
+    int black_count;
+    int num_valid_moves;
 } Game;
 
 
@@ -14,8 +14,7 @@ static void print_horizontal_indices(int j);
 static void print_game_aux(Game *game, int i, int j);
 static void print_game_mode(Game *game);
 static void print_game_score_and_color(Game *game);
-void get_game_score(
-        Game *game, int i, int j, int *white_count, int *black_count);
+void get_game_score(Game *game, int *white_count, int *black_count);
 static void print_header_separator(int i);
 static void store_string(gint i, gchar *source, gchar *dest);
 static int copy_entire_file_except_line(
@@ -207,7 +206,7 @@ void update_game_info(Game *game)
     gchar player_1_color[10], player_2_color[10];
 
     // Count the amount of black and white discs.
-    get_game_score(game, 0, 0, &white_count, &black_count);
+    get_game_score(game, &white_count, &black_count);
 
     // Store the counts according to the players' colors.
     if (game->players_color.player_1 == white)
@@ -360,6 +359,29 @@ void print_best_possible_move(Move move, int best_score)
 }
 
 
+// Print what the search did to find the best move, as a single
+// line of "key=value" fields that scripts can parse. A move of the
+// opening book has depth 0 and no nodes.
+void print_search_log(Move move, int best_score, const Search_result *result)
+{
+    const Search_counters *counters = &result->counters;
+
+    printf(
+            "search move=%c%c score=%d depth=%d max_ply=%d nodes=%lu "
+            "nps=%.0f evaluations=%lu cutoffs=%lu first_cutoff_rate=%.3f "
+            "probcuts=%lu table_probes=%lu table_hits=%lu "
+            "table_hit_rate=%.3f time=%.3f\n",
+            move.column + 'A', move.row + '1', best_score, result->depth,
+            counters->max_ply, counters->nodes,
+            counters->elapsed > 0 ? counters->nodes / counters->elapsed : 0,
+            counters->evaluations, counters->cutoffs,
+            get_first_move_cutoff_rate(counters), counters->probcuts,
+            counters->table_probes,
+            counters->table_hits, get_table_hit_rate(counters),
+            counters->elapsed);
+}
+
+
 // Print the horizontal separators for every row
 // in the board.
 //
@@ -414,7 +436,7 @@ static void print_game_score_and_color(Game *game)
     int white_count = 0;
 
     // Calculate the game score.
-    get_game_score(game, 0, 0, &white_count, &black_count);
+    get_game_score(game, &white_count, &black_count);
 
     // Print the current game score along with the
     // corresponding color of each player.
@@ -473,26 +495,12 @@ static void print_game_score_and_color(Game *game)
 }
 
 
-void get_game_score(
-        Game *game, int i, int j, int *white_count, int *black_count)
+// Gets the number of discs of each color (which the game keeps
+// up to date after every move).
+void get_game_score(Game *game, int *white_count, int *black_count)
 {
-    // Base case. End of the board.
-    if (i == BOARD_SIZE)
-        return;
-
-    // Recursive case. End of the row. Go to the next row.
-    if (j == BOARD_SIZE)
-        return get_game_score(game, ++i, 0, white_count, black_count);
-
-    // Recursive case. Go to the next column.
-    if ((*game).board[i][j].status == full)
-    {
-        if ((*game).board[i][j].color == white)
-            ++(*white_count);
-        else
-            ++(*black_count);
-    }
-    return get_game_score(game, i, ++j, white_count, black_count);
+    *white_count = (*game).white_count;
+    *black_count = (*game).black_count;
 }
 
 
@@ -546,7 +554,7 @@ void print_game_over(Game game)
     int white_count = 0;
 
     // Count the amount of black and white discs.
-    get_game_score(&game, 0, 0, &white_count, &black_count);
+    get_game_score(&game, &white_count, &black_count);
 
     // Draw. Exit the function.
     if (black_count == white_count)
@@ -622,7 +630,7 @@ void update_game_statistics(Game game)
     gchar output_string[1000];
 
     // Count the amount of black and white discs.
-    get_game_score(&game, 0, 0, &white_count, &black_count);
+    get_game_score(&game, &white_count, &black_count);
 
     // Update the flags according to the results of the game.
     int games_won = 0, games_lost = 0, draws = 0;
@@ -2,6 +2,7 @@
 #define _INPUT_OUTPUT_
 
 #include "../game.h"
+#include "../minimax/minimax.h"
 
 void draw_callback(GtkWidget *widget, cairo_t *cr, gpointer data);
 void update_game_info(Game *game);
@@ -13,9 +14,9 @@ void prompt_user(void);
 void print_game_information(Game *game, int limit, int i);
 void print_select_first_player(Game *game);
 void print_select_first_player_result(Game *game, char selection);
-void get_game_score(
-        Game *game, int i, int j, int *white_count, int *black_count);
+void get_game_score(Game *game, int *white_count, int *black_count);
 void print_best_possible_move(Move move, int best_score);
+void print_search_log(Move move, int best_score, const Search_result *result);
 void print_game_over(Game game);
 void print_invalid_input_machine(char input_string[5]);
 void print_illegal_move_machine(Move move);
@@ -15,46 +15,52 @@
 #define CPU_2_READ_PATH "cpu_1.txt"
 #define CPU_2_WRITE_PATH "cpu_2.txt"
 
+// A CPU move being chosen by the engine thread: a copy of the game
+// for the thread to work on, the game it will be played on (and
+// the number of that game) and the move that was chosen.
+typedef struct Cpu_task
+{
+    Game game_copy;
+    Game *game;
+    guint game_number;
+    Move move;
+} Cpu_task;
+
+// Whether to print the counters of every search of the CPU.
+static char search_log;
+
 
 void button_pressed_callback(GtkWidget *widget, GdkEvent *event, Game *game);
 static void human_move(Game *game, Move move);
-static void cpu_move(Game *game);
+void cpu_move(Game *game);
+void start_game(Game *game);
+static void reset_engine(Game *game);
+static gpointer cpu_thread(gpointer data);
+static gboolean play_cpu_move(gpointer data);
+static char is_cpu_turn(Game *game);
+static void choose_cpu_move(Game *game, Move *move);
 void turn_transition(Game *game, Move move);
+static void check_game_over(Game *game);
 static void game_over_function(Game *game);
 static void set_text_game_over(Game *game, gchar *text);
 static void set_text_aux(
         Game *game, gchar *text, color color, gboolean draw,
         gint white_count, gint black_count);
 void mark_valid_moves(Game *game, color color);
-static void mark_valid_moves_all_directions(
-        Game *game, color color, direction dir);
-static void mark_valid_moves_all_arrays(
-        Game *game, color color, direction dir, int i, int j);
-static void mark_valid_moves_array(
-        Game *game, color color, direction dir,
-        int i, int j, pattern previous);
+void game_to_position(Game *game, color color, Position *position);
 color get_players_color(Game game);
-static void reverse_color(Game *game, Move move, color color);
-static void reverse_color_all_directions(
-        Game *game, Move move, color color, direction dir);
-static void reverse_color_in_array(
-        Game *game, Move move, color color, direction dir,
-        char going_back, int i, int j);
-static void delete_all_valid_moves(Game *game, int i, int j);
+static int reverse_color(Game *game, Move move, color color);
 static void get_human_move(Game game, Move *move);
 void get_machine_move(Game game, Move *move);
+int find_best_move(Game *game, Move *move, Search_result *result);
+void set_search_log(char enabled);
+void ponder_game(Game *game);
 void transform_board(Game *game, Move move);
 void switch_player(turn *turn);
-static void get_starting_indices(direction dir, int *i, int *j);
-static char get_next_array(direction dir, int *i, int* j);
-static void reverse_direction(direction *dir, char *going_back);
-static void change_discs_color(color *color);
-static void get_next_array_position(direction dir, int *i, int *j);
 static void read_user_input(Move *move, int i);
 static void convert_board_to_string(
         Game *game, char string_board[], int i, int j);
 char check_for_valid_moves(Game *game);
-static char check_for_valid_moves_aux(Game *game, int i, int j);
 static void get_opponents_cpu_move_from_file(Game *game, Move *move);
 static void save_move_to_file(Move move);
 static void time_delay(time_t seconds);
@@ -69,6 +75,10 @@ void button_pressed_callback(GtkWidget *widget, GdkEvent *event, Game *game)
     // Struct to store the move.
     Move move;
 
+    // Ignore the clicks while the CPU is thinking.
+    if (game->cpu_thinking)
+        return;
+
     // Get the height and width of the drawing widget.
     width = gtk_widget_get_allocated_width(widget);
     height = gtk_widget_get_allocated_height(widget);
@@ -113,31 +123,13 @@ void button_pressed_callback(GtkWidget *widget, GdkEvent *event, Game *game)
         human_move(game, move);
     }
 
-    // CPU's turn.
-    // Check if the game is running and if it's the CPU's turn.
-    if (
-            game->state == running &&
-            game->mode == single_player && game->turn == player_2 ||
-            game->mode == cpu_vs_itself ||
-            game->mode == cpu_vs_another_cpu)// && game->turn == player_1)
-    {
-        // Computer's move, as usual.
+    // CPU's turn. The CPU keeps playing on its own (see
+    // play_cpu_move()) while it's its turn.
+    if (is_cpu_turn(game))
         cpu_move(game);
-        // Let the CPU play continuously if the user's turn gets
-        // skipped every time.
-        while (
-                game-> state == running &&
-                game->mode == single_player &&
-                game->turn == player_2)
-            cpu_move(game);
-    }
 
     // Show the game over window if the game is over.
-    if (game->state == game_over)
-    {
-        gtk_widget_show_all((GtkWidget *) game_over_window);
-        game_over_function(game);
-    }
+    check_game_over(game);
     return;
 }
 
@@ -150,9 +142,6 @@ static void human_move(Game *game, Move move)
             (game->mode != single_player && game->mode != two_players) ||
             (game->mode == single_player && game->turn == player_2))
     {
-        ///////////////////
-        printf("\nHUMAN RETURN\n");
-        ///////////////////
         return;
     }
 
@@ -165,47 +154,154 @@ static void human_move(Game *game, Move move)
 }
 
 
-// Executes the CPU's move, if appropiate.
-static void cpu_move(Game *game)
+// Starts choosing the CPU's move, if appropiate.
+//
+// The move is chosen by a thread of its own, so that the window
+// keeps responding while the CPU thinks. When the move is ready,
+// it's played from the GTK main loop (see play_cpu_move()).
+void cpu_move(Game *game)
 {
-    // Exit the function if it's not the CPU's turn.
-    if (
-            (game->mode == single_player && game->turn == player_1) ||
-            game->mode == two_players)// ||
-            //(game->mode == cpu_vs_another_cpu && game->turn == player_2))
-    {
-        ///////////////////
-        printf("\nCPU RETURN\n");
-        ///////////////////
+    // Exit the function if it's not the CPU's turn, or if the CPU
+    // is already thinking.
+    if (!is_cpu_turn(game) || game->cpu_thinking)
         return;
+
+    // The thread works on a copy of the game, because the original
+    // is drawn by the main loop in the meantime.
+    Cpu_task *task = g_slice_new(Cpu_task);
+    task->game_copy = *game;
+    task->game = game;
+    task->game_number = game->game_number;
+
+    game->cpu_thinking = TRUE;
+    g_thread_unref(g_thread_new("cpu_move", cpu_thread, task));
+}
+
+
+// Sets the engine up for a game that was just started on the
+// board.
+//
+// The engine runs one search at a time, so if the CPU is still
+// thinking about a move of the last game, the move is dropped when
+// it's ready and the engine is set up then (see play_cpu_move()).
+void start_game(Game *game)
+{
+    game->game_number++;
+    if (!game->cpu_thinking)
+        reset_engine(game);
+}
+
+
+// Forgets what the engine searched in the last game, and starts
+// thinking about the first move if the computer plays first.
+static void reset_engine(Game *game)
+{
+    stop_pondering();
+    clear_search();
+
+    if (game->turn == player_2 && game->mode == single_player)
+        cpu_move(game);
+}
+
+
+// Body of the thread that chooses the CPU's move. Hands the move
+// over to the main loop when it's done.
+static gpointer cpu_thread(gpointer data)
+{
+    Cpu_task *task = data;
+
+    choose_cpu_move(&task->game_copy, &task->move);
+    g_idle_add(play_cpu_move, task);
+    return NULL;
+}
+
+
+// Plays the move chosen by the CPU thread. Called from the GTK
+// main loop, so the board is redrawn between two CPU moves.
+static gboolean play_cpu_move(gpointer data)
+{
+    Cpu_task *task = data;
+    Game *game = task->game;
+
+    game->cpu_thinking = FALSE;
+
+    // The move is from a game that was left for a new one.
+    if (task->game_number != game->game_number)
+    {
+        g_slice_free(Cpu_task, task);
+        reset_engine(game);
+        return G_SOURCE_REMOVE;
     }
 
-    // If it's the CPU's turn, make the transition.
+    // The opponent's CPU could have made an invalid move.
+    if (task->game_copy.state == game_over)
+        game->state = game_over;
     else
-    {
-        Move move;
+        turn_transition(game, task->move);
+    g_slice_free(Cpu_task, task);
 
-        // Single player game mode.
-        if (game->mode == single_player)
-        {
-            get_machine_move(*game, &move);
-        }
+    // Let the CPU play continuously if it's its turn again (the
+    // user's turn got skipped, or the CPU plays both sides).
+    if (is_cpu_turn(game))
+        cpu_move(game);
 
-        // Against another program.
-        else if (game->mode == cpu_vs_another_cpu && game->turn == player_1)
-        {
-            get_machine_move(*game, &move);
-            save_move_to_file(move);
-        }
-        else
-        {
-            get_opponents_cpu_move_from_file(game, &move);
-        }
+    // Otherwise, think while the user thinks (if pondering is
+    // enabled).
+    else if (game->state == running && game->mode == single_player)
+        ponder_game(game);
 
-        // Transition to the next turn.
-        turn_transition(game, move);
+    // Show the game over window if the game is over.
+    check_game_over(game);
+    return G_SOURCE_REMOVE;
+}
+
+
+// Returns whether the game is running and it's the CPU's turn.
+static char is_cpu_turn(Game *game)
+{
+    return
+        game->state == running &&
+        ((game->mode == single_player && game->turn == player_2) ||
+         game->mode == cpu_vs_itself ||
+         game->mode == cpu_vs_another_cpu);
+}
+
+
+// Chooses the CPU's move (or reads the move of the opponent's
+// CPU). Runs on the CPU thread.
+static void choose_cpu_move(Game *game, Move *move)
+{
+    // Single player game mode, or the CPU against itself.
+    if (game->mode == single_player || game->mode == cpu_vs_itself)
+    {
+        get_machine_move(*game, move);
+    }
+
+    // Against another program.
+    else if (game->turn == player_1)
+    {
+        get_machine_move(*game, move);
+        save_move_to_file(*move);
+
+        // When the opponent's CPU has no valid moves left, it
+        // writes "PASO" to the file. It's read (with no effect) and
+        // deleted here, so that the main loop doesn't wait for it
+        // (see turn_transition()).
+        Game after_move = *game;
+        Move pass;
+
+        transform_board(&after_move, *move);
+        if (!check_for_valid_moves(&after_move))
+            get_opponents_cpu_move_from_file(&after_move, &pass);
+    }
+    else
+    {
+        // Think while the opponent's CPU thinks (if pondering is
+        // enabled).
+        ponder_game(game);
+        get_opponents_cpu_move_from_file(game, move);
+        stop_pondering();
     }
-    return;
 }
 
 
@@ -224,19 +320,11 @@ void turn_transition(Game *game, Move move)
     else
     {
         // If we are playing against another CPU, we have to make
-        // sure to print "PASO" to the file when skipping turns
-        // and to delete the file when our opponent's CPU is
-        // skipping turns.
-        if (game->mode == cpu_vs_another_cpu)
-        {
-            // Read the file (with no effect) and delete it.
-            if (game->turn == player_1)
-                get_opponents_cpu_move_from_file(game, &move);
-
-            // If I don't have any valid moves to make, print "PASO".
-            else
-                print_paso_to_file();
-        }
+        // sure to print "PASO" to the file when skipping turns. When
+        // our opponent's CPU skips its turn, the CPU thread has
+        // already read and deleted the file (see choose_cpu_move()).
+        if (game->mode == cpu_vs_another_cpu && game->turn == player_2)
+            print_paso_to_file();
 
         // Mark all squares where the next move could be made.
         mark_valid_moves(game, get_players_color(*game));
@@ -261,6 +349,30 @@ void turn_transition(Game *game, Move move)
 }
 
 
+// Shows the game over window if the game is over.
+static void check_game_over(Game *game)
+{
+    if (game->state == game_over)
+    {
+        stop_pondering();
+        gtk_widget_show_all((GtkWidget *) game_over_window);
+        game_over_function(game);
+    }
+}
+
+
+// Puts the board of the game back to the starting position. No
+// square is marked as a valid move until mark_valid_moves() is
+// called.
+void reset_board(Game *game)
+{
+    initialize_board((*game).board, 0, 0);
+    (*game).white_count = 2;
+    (*game).black_count = 2;
+    (*game).num_valid_moves = 0;
+}
+
+
 void initialize_board(Square board[BOARD_SIZE][BOARD_SIZE], int i, int j)
 {
     // Base case. End of the board.
@@ -307,7 +419,7 @@ static void set_text_game_over(Game *game, gchar *text)
     gint white_count = 0;
     gint black_count = 0;
     // Count the amount of black and white discs.
-    get_game_score(game, 0, 0, &white_count, &black_count);
+    get_game_score(game, &white_count, &black_count);
 
     // Set the new text according to who won.
     // Black has won.
@@ -375,18 +487,9 @@ void transform_game(Game *game)
     // Recursive case. Main menu.
     else if ((*game).state == main_menu)
     {
-        /////////////////////////////////////////
         main_menu_function(game);
-        /////////////////////////////////////////
-        //
-        //(*game).mode = 4;
-        //(*game).turn = player_1;
-        //(*game).players_color.player_1 = black;
-        //(*game).players_color.player_2 = white;
-        //
-        /////////////////////////////////////////
-
-        initialize_board((*game).board, 0, 0);
+
+        reset_board(game);
         (*game).state = running;
 
         // Mark all squares where the first move could me made.
@@ -494,304 +597,99 @@ void transform_board(Game *game, Move move)
         (*game).board[move.row][move.column].color = color;
 
     // Reverse the color of the corresponding discs.
-    reverse_color(game, move, color);
+    int num_flipped = reverse_color(game, move, color);
+
+    // Update the disc counts: the new disc and the flipped ones
+    // change hands.
+    if (color == white)
+    {
+        (*game).white_count += 1 + num_flipped;
+        (*game).black_count -= num_flipped;
+    }
+    else
+    {
+        (*game).black_count += 1 + num_flipped;
+        (*game).white_count -= num_flipped;
+    }
 
     // Mark all squares where the next move could me made.
     mark_valid_moves(game, !color);
 }
 
 
-static void reverse_color(Game *game, Move move, color color)
+// Reverses the color of the discs flanked by the move.
+//
+// Returns the number of discs flipped.
+static int reverse_color(Game *game, Move move, color color)
 {
-    reverse_color_all_directions(game, move, color, north);
-}
+    Position position;
 
+    // Get the discs flipped by the move, all at once.
+    game_to_position(game, color, &position);
+    Bitboard flipped = get_flipped_discs(
+            &position, move.row * BOARD_WIDTH + move.column);
+    int num_flipped = count_discs(flipped);
 
-static void reverse_color_all_directions(
-        Game *game, Move move, color color, direction dir)
-{
-    // Base case. Last direction.
-    if (dir == north_west)
+    while (flipped)
     {
-        reverse_color_in_array(game, move, color, dir, FALSE, move.row, move.column);
-        return;
+        int square = pop_first_square(&flipped);
+        (*game).board[square / BOARD_WIDTH][square % BOARD_WIDTH].color =
+            color;
     }
-
-    // Recursive case. Search on the next direction.
-    reverse_color_in_array(game, move, color, dir, FALSE, move.row, move.column);
-    return reverse_color_all_directions(game, move, color, ++dir);
-}
-
-
-static void reverse_color_in_array(
-        Game *game, Move move, color color, direction dir,
-        char going_back, int i, int j)
-{
-    // Base cases.
-    if (
-            // End of matrix.
-            (i == BOARD_SIZE || j == BOARD_SIZE || i == -1 || j == -1) ||
-            // Went back to the starting square.
-            (going_back && (int)move.row == i && (int)move.column == j) ||
-            // Found a non-full square.
-            ((*game).board[i][j].status != full)
-            )
-        return;
-
-    // Recursive case. Found a square with the same color, go back.
-    if (
-            !going_back &&
-            (*game).board[i][j].status == full &&
-            (*game).board[i][j].color == color &&
-            ((int)move.row != i || (int)move.column != j))
-        reverse_direction(&dir, &going_back);
-
-    // Recursive case. Going back and reversing discs.
-    else if (going_back && (*game).board[i][j].color != color)
-        change_discs_color(&(*game).board[i][j].color);
-
-    // Recursive case. Go to the next square.
-    get_next_array_position(dir, &i, &j);
-    return reverse_color_in_array(game, move, color, dir, going_back, i, j);
-}
-
-
-static void reverse_direction(direction *dir, char *going_back)
-{
-    *dir = (*dir + 4) % 8;
-    *going_back = TRUE;
+    return num_flipped;
 }
 
 
+// Marks the squares where the given color can play as valid,
+// and clears the marks left from the previous play.
 void mark_valid_moves(Game *game, color color)
 {
-    // Delete the valid moves for the previous play.
-    delete_all_valid_moves(game, 0, 0);
-
-    // Mark the valid moves for the current play.
-    mark_valid_moves_all_directions(game, color, north);
-}
-
-
-static void mark_valid_moves_all_directions(
-        Game *game, color color, direction dir)
-{
-    int i, j;
-
-    // Get the starting indices for a given direction.
-    get_starting_indices(dir, &i, &j);
-
-    // Mark valid moves for all arrays in a given direction.
-    mark_valid_moves_all_arrays(game, color, dir, i, j);
-
-    // Base case. Last direction.
-    if (dir == north_west)
-        return;
-
-    // Recursive case. Go to the next direction.
-    return mark_valid_moves_all_directions(game, color, ++dir);
-}
-
-
-static void mark_valid_moves_all_arrays(
-        Game *game, color color, direction dir, int i, int j)
-{
-    // Mark valid moves in an array.
-    mark_valid_moves_array(game, color, dir, i, j, empty_pattern);
+    Position position;
 
-    // Base case. All arrays in a given direction were traversed.
-    if (!get_next_array(dir, &i, &j))
-        return;
+    // Get the valid moves for the given color.
+    game_to_position(game, color, &position);
+    Bitboard moves = get_valid_moves(&position);
+    (*game).num_valid_moves = count_discs(moves);
 
-    // Recursive case. Go to the next array.
-    return mark_valid_moves_all_arrays(game, color, dir, i, j);
-}
-
-
-static char get_next_array(direction dir, int *i, int* j)
-{
-    switch (dir)
+    // Update the status of every square that isn't full.
+    for (int i = 0; i < BOARD_SIZE; i++)
     {
-        case north:
-            ++(*j);
-            break;
-        case north_east:
-            if (*i == BOARD_SIZE-1)
-                ++(*j);
-            else
-                ++(*i);
-            break;
-        case east:
-            ++(*i);
-            break;
-        case south_east:
-            if (*j == 0)
-                ++(*i);
-            else
-                --(*j);
-            break;
-        case south:
-            --(*j);
-            break;
-        case south_west:
-            if (*i == 0)
-                --(*j);
-            else
-                --(*i);
-            break;
-        case west:
-            --(*i);
-            break;
-        case north_west:
-            if (*j == BOARD_SIZE-1)
-                --(*i);
-            else
-                ++(*j);
-            break;
-    }
-
-    // Check if we have reached the limits. Return 0 if we have.
-    if (
-            (*i == BOARD_SIZE || *j == BOARD_SIZE || *i == -1 || *j == -1) ||
-            (dir == north_east && *j == 6) ||
-            (dir == south_east && *i == 6) ||
-            (dir == south_west && *j == 1) ||
-            (dir == north_west && *i == 1)
-            )
-        return 0;
-
-    // If we haven't reached the limits, return 1.
-    return 1;
-}
-
+        for (int j = 0; j < BOARD_SIZE; j++)
+        {
+            if ((*game).board[i][j].status == full)
+                continue;
 
-static void get_starting_indices(direction dir, int *i, int *j)
-{
-    switch (dir)
-    {
-        case north:
-            *i = BOARD_SIZE-1;
-            *j = 0;
-            break;
-        case north_east:
-            *i = 2;
-            *j = 0;
-            break;
-        case east:
-            *i = 0;
-            *j = 0;
-            break;
-        case south_east:
-            *i = 0;
-            *j = 5;
-            break;
-        case south:
-            *i = 0;
-            *j = BOARD_SIZE-1;
-            break;
-        case south_west:
-            *i = 5;
-            *j = BOARD_SIZE-1;
-            break;
-        case west:
-            *i = BOARD_SIZE-1;
-            *j = BOARD_SIZE-1;
-            break;
-        case north_west:
-            *i = BOARD_SIZE-1;
-            *j = 2;
-            break;
+            if (moves & SQUARE_BIT(i * BOARD_WIDTH + j))
+                (*game).board[i][j].status = valid;
+            else
+                (*game).board[i][j].status = empty;
+        }
     }
 }
 
 
-static void mark_valid_moves_array(
-        Game *game, color color, direction dir,
-        int i, int j, pattern previous)
+// Converts the board of the game to a bitboard position, seen
+// from the side of the given color.
+void game_to_position(Game *game, color color, Position *position)
 {
-    // Base case. End of matrix.
-    if (i == BOARD_SIZE || j == BOARD_SIZE || i == -1 || j == -1)
-        return;
-
-    // Base case. Found a valid square.
-    if (
-            (*game).board[i][j].status != full &&
-            previous == same_and_opposite_color)
+    position->player = 0;
+    position->opponent = 0;
+    for (int i = 0; i < BOARD_SIZE; i++)
     {
-        (*game).board[i][j].status = valid;
-        return;
-    }
-
-    // Recursive case.
-    if ((*game).board[i][j].status != full)
-        previous = empty_pattern;
-    else if (
-            (*game).board[i][j].status == full &&
-            (*game).board[i][j].color == color)
-        previous = same_color;
-    else if (
-            (*game).board[i][j].status == full &&
-            (*game).board[i][j].color != color &&
-            previous == same_color)
-        previous = same_and_opposite_color;
-    get_next_array_position(dir, &i, &j);
-    return mark_valid_moves_array(game, color, dir, i, j, previous);
-}
-
+        for (int j = 0; j < BOARD_SIZE; j++)
+        {
+            if ((*game).board[i][j].status != full)
+                continue;
 
-static void get_next_array_position(direction dir, int *i, int *j)
-{
-    switch (dir)
-    {
-        case north:
-            --(*i);
-            break;
-        case north_east:
-            --(*i);
-            ++(*j);
-            break;
-        case east:
-            ++(*j);
-            break;
-        case south_east:
-            ++(*i);
-            ++(*j);
-            break;
-        case south:
-            ++(*i);
-            break;
-        case south_west:
-            ++(*i);
-            --(*j);
-            break;
-        case west:
-            --(*j);
-            break;
-        case north_west:
-            --(*i);
-            --(*j);
-            break;
+            if ((*game).board[i][j].color == color)
+                position->player |= SQUARE_BIT(i * BOARD_WIDTH + j);
+            else
+                position->opponent |= SQUARE_BIT(i * BOARD_WIDTH + j);
+        }
     }
 }
 
 
-static void delete_all_valid_moves(Game *game, int i, int j)
-{
-    // Base case. End of the matrix.
-    if (i == BOARD_SIZE)
-        return;
-
-    // Recursive case. Go to the next row.
-    else if (j == BOARD_SIZE)
-        return delete_all_valid_moves(game, ++i, 0);
-
-    // Recursive case. Go to the next column.
-    if ((*game).board[i][j].status == valid)
-        (*game).board[i][j].status = empty;
-    return delete_all_valid_moves(game, i, ++j);
-}
-
-
 void switch_player(turn *turn)
 {
     if (*turn == player_1)
@@ -801,15 +699,6 @@ void switch_player(turn *turn)
 }
 
 
-static void change_discs_color(color *color)
-{
-    if (*color == white)
-        *color = black;
-    else
-        *color = white;
-}
-
-
 static void get_human_move(Game game, Move *move)
 {
     prompt_user();
@@ -908,11 +797,86 @@ void get_machine_move(Game game, Move *move)
     //////////////////////////////////////////////////////////
 
     // Find the best move and store it in a variable.
-    int best_score = find_best_move(&game, move);
+    Search_result result;
+    int best_score = find_best_move(&game, move, &result);
 
     // Print the best move and the minimax score
     // associated with it.
     print_best_possible_move((*move), best_score);
+    if (search_log)
+        print_search_log((*move), best_score, &result);
+}
+
+
+// Turns the log line of every search of the CPU (see
+// print_search_log()) on or off.
+void set_search_log(char enabled)
+{
+    search_log = enabled;
+}
+
+
+// Finds the best move possible in this board configuration
+// using the Minimax algorithm.
+//
+// The game is converted to a bitboard position once, here, and
+// the whole search runs on positions (16 bytes each) instead of
+// copies of the game struct (see minimax.c, which doesn't know
+// about the game struct).
+//
+// Arguments:
+// The game struct, which represents the state of the game.
+// A "move" struct to store the best possible move.
+// A struct to store the result of the search, with its counters
+// (all of them 0, and the depth too, for a move of the opening
+// book).
+//
+// Returns the minimax score of the best possible move,
+// being black the minimizer and white the maximizer (0 for a move
+// of the opening book).
+int find_best_move(Game *game, Move *move, Search_result *result)
+{
+    Position position;
+
+    // Find out if the player is the minimizer or the
+    // maximizer.
+    color color = get_players_color(*game);
+    char is_max = color == white;
+
+    // Convert the board to the search representation.
+    game_to_position(game, color, &position);
+
+    // Play the move of the opening book, if the position is in
+    // it.
+    if (probe_opening_book(&position, &result->square))
+    {
+        (*move).row = result->square / BOARD_WIDTH;
+        (*move).column = result->square % BOARD_WIDTH;
+        result->score = 0;
+        result->depth = 0;
+        memset(&result->counters, 0, sizeof(Search_counters));
+        return 0;
+    }
+
+    search_position(&position, is_max, result);
+
+    (*move).row = result->square / BOARD_WIDTH;
+    (*move).column = result->square % BOARD_WIDTH;
+
+    // Return the best possible score.
+    return result->score;
+}
+
+
+// Starts pondering on the position of the game, where the
+// opponent of the CPU is to move (see start_pondering()).
+void ponder_game(Game *game)
+{
+    Position position;
+    color color = get_players_color(*game);
+
+    game_to_position(game, color, &position);
+    start_pondering(&position, color == white);
 }
 
 
@@ -958,28 +922,7 @@ static void convert_board_to_string(
 
 char check_for_valid_moves(Game *game)
 {
-    return check_for_valid_moves_aux(game, 0, 0);
-}
-
-
-// Returns TRUE if there is at least one valid move.
-// Returns FALSE if there are no valid moves.
-static char check_for_valid_moves_aux(Game *game, int i, int j)
-{
-    // Base case. Reached the end of the board.
-    if (i == BOARD_SIZE)
-        return FALSE;
-
-    // Recursive case. Go to the next row.
-    if (j == BOARD_SIZE)
-        return check_for_valid_moves_aux(game, ++i, 0);
-
-    // Base case. We found a valid move.
-    else if ((*game).board[i][j].status == valid)
-        return TRUE;
-
-    // Recursive case. Go to the next column.
-    return check_for_valid_moves_aux(game, i, ++j);
+    return (*game).num_valid_moves > 0;
 }
 
 
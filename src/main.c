@@ -1,8 +1,14 @@
 #include <gtk/gtk.h>
+#include <string.h>
 #include "game.h"
 #include "logic/logic.h"
 #include "input_output/menu_io.h"
 #include "input_output/game_io.h"
+#include "bitboard/bitboard.h"
+#include "minimax/minimax.h"
+#include "minimax/transposition.h"
+#include "minimax/endgame.h"
+#include "benchmark/benchmark.h"
 
 GtkBuilder *builder;
 GtkWidget *window, *drawing_area, *event_box, *main_menu_window,
@@ -31,6 +37,14 @@ GtkTextBuffer *buffer;
 // Variables to store the names of the players.
 gchar *player_name, *opponents_name;
 
+// Weights of the evaluation read with --weights, pattern tables
+// read with --patterns, network read with --nnue and calibration of
+// ProbCut read with --probcut.
+static Evaluation_weights weights;
+static Pattern_tables pattern_tables;
+static Nnue_network network;
+static Probcut_parameters probcut_parameters;
+
 typedef struct {
     GtkWidget *w_txtvw_main;            // Pointer to text view object
     GtkWidget *w_dlg_file_choose;       // Pointer to file chooser dialog box
@@ -71,6 +85,18 @@ static void save_game_callback(void);
 static void filechooser_load_game(void);
 static void filechooser_close(void);
 
+// Reports that run without the graphical interface, requested on
+// the command line (0 when they weren't requested).
+typedef struct Reports
+{
+    int smp_threads;
+    int perft_depth;
+    int bench_depth;
+} Reports;
+
+static void parse_arguments(
+        int argc, char **argv, Search_options *options, Reports *reports);
+
 int main(int argc, char **argv)
 {
     // Allocate memory for the about dialog.
@@ -79,6 +105,34 @@ int main(int argc, char **argv)
     // Declare a game struct to store the state of the game.
     Game game;
 
+    // Fill the lookup tables used by the game rules.
+    init_bitboard();
+
+    // Read the settings of the search engine from the command line
+    // and set the engine up.
+    Search_options options;
+    Reports reports;
+    parse_arguments(argc, argv, &options, &reports);
+    if (!init_search(&options))
+    {
+        fprintf(
+                stderr,
+                "Could not allocate a transposition table of %d MB.\n",
+                options.hash_size);
+        return 1;
+    }
+
+    // The reports run without the graphical interface.
+    if (reports.smp_threads)
+    {
+        print_smp_report(&options, reports.smp_threads);
+        return 0;
+    }
+    if (reports.perft_depth)
+        return print_perft_report(reports.perft_depth) ? 0 : 1;
+    if (reports.bench_depth)
+        return print_bench_report(&options, reports.bench_depth) ? 0 : 1;
+
     // Initialize everything needed to operate the toolkit.
     gtk_init(&argc, &argv);
 
@@ -337,6 +391,9 @@ int main(int argc, char **argv)
     // Initialize the game state to "main_menu" and the game board.
     //initialize_board(game.board, 0, 0);
     game.state = main_menu;
+    game.cpu_thinking = FALSE;
+    game.game_number = 0;
+    reset_board(&game);
     game.builder = builder;
     game.drawing_area = drawing_area;
 
@@ -355,6 +412,149 @@ int main(int argc, char **argv)
     return 0;
 }
 
+// Reads the settings of the search engine from the command line.
+// Arguments that aren't recognized (such as the ones for GTK) are
+// ignored.
+//
+// Options:
+// --hash-size=MB       Size of the transposition table, in megabytes.
+// --move-time=SECONDS  Time the CPU can think about every move.
+// --depth=N            Maximum depth of the search.
+// --threads=N          Number of threads of the search.
+// --endgame-empties=N  Number of empty squares from which the game
+//                      is solved to the end.
+// --book=FILE          Opening book (see src/book/book_builder.c).
+// --weights=FILE       Weights of the evaluation (see
+//                      src/minimax/weights.txt).
+// --patterns=FILE      Pattern tables for the evaluation (see
+//                      src/patterns/pattern_trainer.c).
+// --nnue=FILE          Network for the evaluation (see
+//                      src/nnue/nnue_trainer.c).
+// --probcut=FILE       Prune with ProbCut, calibrated for the
+//                      evaluation (see
+//                      src/minimax/probcut_calibrator.c).
+// --engine=NAME        Engine that searches before the endgame:
+//                      alpha-beta (the default) or mcts.
+// --playouts=N         Maximum number of playouts of the MCTS engine
+//                      for every move.
+// --ponder             Think while the opponent is thinking.
+// --search-log         Print the counters of every search of the
+//                      CPU, in a line of "key=value" fields.
+// --smp-report=N       Print how the search scales from 1 to N
+//                      threads and exit.
+// --perft=N            Count the leaves of the game tree to depth N
+//                      from the test positions and exit.
+// --bench[=N]          Search the test positions to depth N (by
+//                      default, DEFAULT_BENCH_DEPTH) and exit.
+static void parse_arguments(
+        int argc, char **argv, Search_options *options, Reports *reports)
+{
+    reports->smp_threads = 0;
+    reports->perft_depth = 0;
+    reports->bench_depth = 0;
+
+    // Default settings.
+    options->hash_size = DEFAULT_HASH_SIZE;
+    options->move_time = DEFAULT_MOVE_TIME;
+    options->max_depth = 0;
+    options->threads = 1;
+    options->endgame_empties = DEFAULT_ENDGAME_EMPTIES;
+    options->book_path = NULL;
+    options->ponder = FALSE;
+    options->weights = NULL;
+    options->patterns = NULL;
+    options->network = NULL;
+    options->probcut = NULL;
+    options->engine = ENGINE_ALPHA_BETA;
+    options->max_playouts = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        int value;
+        long playouts;
+        double seconds;
+
+        if (sscanf(argv[i], "--hash-size=%d", &value) == 1 && value > 0)
+            options->hash_size = value;
+        else if (
+                sscanf(argv[i], "--move-time=%lf", &seconds) == 1 &&
+                seconds > 0)
+            options->move_time = seconds;
+        else if (sscanf(argv[i], "--depth=%d", &value) == 1 && value > 0)
+            options->max_depth = value;
+        else if (sscanf(argv[i], "--threads=%d", &value) == 1 && value > 0)
+            options->threads = value;
+        else if (
+                sscanf(argv[i], "--endgame-empties=%d", &value) == 1 &&
+                value >= 0)
+            options->endgame_empties = value;
+        else if (!strncmp(argv[i], "--book=", strlen("--book=")))
+            options->book_path = argv[i] + strlen("--book=");
+        else if (!strncmp(argv[i], "--weights=", strlen("--weights=")))
+        {
+            // Without the file, the default weights are used.
+            const char *path = argv[i] + strlen("--weights=");
+            if (load_weights(path, &weights))
+                options->weights = &weights;
+            else
+                fprintf(stderr, "Could not read the weights %s.\n", path);
+        }
+        else if (!strncmp(argv[i], "--patterns=", strlen("--patterns=")))
+        {
+            // Without the tables, the weights are used.
+            const char *path = argv[i] + strlen("--patterns=");
+            if (load_pattern_tables(&pattern_tables, path))
+                options->patterns = &pattern_tables;
+            else
+                fprintf(
+                        stderr, "Could not read the pattern tables %s.\n",
+                        path);
+        }
+        else if (!strncmp(argv[i], "--nnue=", strlen("--nnue=")))
+        {
+            // Without the network, the tables or the weights are
+            // used.
+            const char *path = argv[i] + strlen("--nnue=");
+            if (load_network(&network, path))
+                options->network = &network;
+            else
+                fprintf(stderr, "Could not read the network %s.\n", path);
+        }
+        else if (!strncmp(argv[i], "--probcut=", strlen("--probcut=")))
+        {
+            // Without the calibration, nothing is pruned.
+            const char *path = argv[i] + strlen("--probcut=");
+            if (load_probcut_parameters(path, &probcut_parameters))
+                options->probcut = &probcut_parameters;
+            else
+                fprintf(
+                        stderr, "Could not read the calibration %s.\n",
+                        path);
+        }
+        else if (!strcmp(argv[i], "--engine=alpha-beta"))
+            options->engine = ENGINE_ALPHA_BETA;
+        else if (!strcmp(argv[i], "--engine=mcts"))
+            options->engine = ENGINE_MCTS;
+        else if (sscanf(argv[i], "--playouts=%ld", &playouts) == 1)
+            options->max_playouts = playouts > 0 ? playouts : 0;
+        else if (!strcmp(argv[i], "--ponder"))
+            options->ponder = TRUE;
+        else if (!strcmp(argv[i], "--search-log"))
+            set_search_log(TRUE);
+        else if (
+                sscanf(argv[i], "--smp-report=%d", &value) == 1 &&
+                value > 0)
+            reports->smp_threads = value;
+        else if (sscanf(argv[i], "--perft=%d", &value) == 1 && value > 0)
+            reports->perft_depth = value;
+        else if (!strcmp(argv[i], "--bench"))
+            reports->bench_depth = DEFAULT_BENCH_DEPTH;
+        else if (sscanf(argv[i], "--bench=%d", &value) == 1 && value > 0)
+            reports->bench_depth = value;
+    }
+}
+
+
 // Help --> About
 void on_menuitm_about_activate(GtkMenuItem *menuitem, app_widgets *app_wdgts)
 {
@@ -398,28 +598,21 @@ void on_main_menu_ok_button_button_press_event(GtkWidget *button, Game *game)
     opponents_name =
         gtk_entry_get_text(gtk_builder_get_object(builder, "opponents_name"));
 
+    // Initialize or reset the game board.
+    reset_board(game);
+
     // Update the widgets that show the game information.
     update_game_info(game);
 
-    // Initialize or reset the game board.
-    initialize_board(game->board, 0, 0);
-
     // Set the game state as running.
     game->state = running;
 
     // Mark all squares where the first move could be made.
     mark_valid_moves(game, get_players_color(*game));
 
-    // If the computer plays first, make the move.
-    if (game->turn == player_2 && game->mode == single_player)
-    {
-        // Render the game board in case the CPU plays first.
-        gtk_widget_queue_draw(game->drawing_area);
-
-        Move move;
-        get_machine_move(*game, &move);
-        turn_transition(game, move);
-    }
+    // Forget the last game, and let the computer think about its
+    // move if it plays first.
+    start_game(game);
 
     // Render the game board.
     gtk_widget_queue_draw(game->drawing_area);
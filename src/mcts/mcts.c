@@ -0,0 +1,593 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "mcts.h"
+
+// Square of the move of a node where the player passes.
+#define PASS_SQUARE NUM_SQUARES
+
+// Longest path from the root to a leaf (moves and passes).
+#define MCTS_MAX_PLY (2 * NUM_SQUARES)
+
+// Weight of the exploration term of UCT, for results between 0
+// and 1.
+#define EXPLORATION 0.7
+
+// Playouts of the main thread between two checks of the clock.
+#define PLAYOUTS_PER_CLOCK_CHECK 256
+
+// States of the children of a node. A thread expands a node while
+// the other threads keep doing playouts from it.
+#define UNEXPANDED 0
+#define EXPANDING 1
+#define EXPANDED 2
+
+// A node of the tree. Its children are next to each other in the
+// pool, and the node only keeps the first one.
+//
+// The results are counted for the player who made the move of the
+// node, in half points (2 for a win, 1 for a draw). The visit is
+// counted when a thread goes through the node and the result when
+// the playout is over, so that meanwhile the node looks like a
+// loss to the other threads (the virtual loss) and they spread
+// over other moves.
+typedef struct Mcts_node
+{
+    uint32_t children;
+    int32_t visits;
+    int32_t score;
+    uint8_t num_children;
+    uint8_t square;
+    uint8_t state;
+} Mcts_node;
+
+// State of one of the threads of a search.
+typedef struct Mcts_thread
+{
+    int id;
+    pthread_t handle;
+    uint64_t random;
+    Search_counters counters;
+} Mcts_thread;
+
+// The nodes are taken from one of two pools, in order. Between
+// moves, the part of the tree that is still useful is copied to
+// the other pool and the rest is dropped. Node 0 is never used, so
+// that 0 can mean "no children".
+static Mcts_node *pools[2];
+static uint32_t pool_size;
+static int current_pool;
+static uint32_t nodes_used;
+
+// The root of the tree and its position, if there is a tree.
+static uint32_t root;
+static Position root_position;
+static char root_is_max;
+static char has_tree;
+
+// Limits of the search being run, and whether it has stopped.
+static Mcts_thread threads[MAX_THREADS];
+static int num_threads;
+static double deadline;
+static long max_playouts;
+static long num_playouts;
+static volatile char stop_search;
+
+static int create_pools(int tree_size);
+static uint32_t find_subtree(const Position *position, char is_max);
+static uint32_t find_child(
+        uint32_t parent, const Position *position, char is_max,
+        const Position *target, char target_is_max);
+static void keep_subtree(uint32_t subtree);
+static void *helper_thread(void *argument);
+static void run_playouts(Mcts_thread *thread);
+static void run_iteration(Mcts_thread *thread);
+static int expand_node(Mcts_node *node, const Position *position);
+static Mcts_node *select_child(const Mcts_node *node);
+static int play_randomly(Position position, uint64_t *random);
+static int get_random_square(Bitboard moves, uint64_t *random);
+static uint64_t next_random(uint64_t *random);
+static uint32_t allocate_nodes(int count);
+static double get_time(void);
+
+
+// Searches a position with Monte Carlo Tree Search: the tree grows
+// towards the moves that win the most random playouts, trying less
+// played moves now and then (UCT).
+//
+// If the position is in the tree of the last search (after one or
+// two moves), the search goes on from that part of the tree.
+//
+// Arguments:
+// The position, relative to the side to move, and whether the side
+// to move is white.
+// The limits of the search.
+// A struct to store the most played move, its score and what the
+// search did (the nodes are the playouts, and the depth is the
+// deepest path of the tree).
+//
+// Returns 1 on success and 0 if the tree couldn't be allocated.
+int search_mcts(
+        const Position *position, char is_max,
+        const Mcts_settings *settings, Search_result *result)
+{
+    if (!pools[0] && !create_pools(settings->tree_size))
+        return 0;
+
+    // Keep what's known about the position, or start a new tree.
+    uint32_t subtree = has_tree ? find_subtree(position, is_max) : 0;
+    if (subtree)
+        keep_subtree(subtree);
+    else
+    {
+        nodes_used = 1;
+        root = allocate_nodes(1);
+    }
+    root_position = *position;
+    root_is_max = is_max;
+    has_tree = TRUE;
+
+    num_threads = settings->threads;
+    if (num_threads < 1)
+        num_threads = 1;
+    else if (num_threads > MAX_THREADS)
+        num_threads = MAX_THREADS;
+    max_playouts = settings->max_playouts;
+    num_playouts = 0;
+    stop_search = FALSE;
+
+    double start = get_time();
+    deadline = start + settings->move_time;
+
+    // The root needs its children (if the game isn't over).
+    Mcts_node *root_node = &pools[current_pool][root];
+    if (
+            (root_node->state != EXPANDED &&
+             !expand_node(root_node, position)) ||
+            !root_node->num_children)
+        return 0;
+
+    // With a single move, there's nothing to search.
+    if (root_node->num_children > 1)
+    {
+        for (int i = 0; i < num_threads; i++)
+        {
+            threads[i].id = i;
+            threads[i].random = 0x9e3779b97f4a7c15ULL * (i + 1);
+            memset(&threads[i].counters, 0, sizeof(Search_counters));
+        }
+        for (int i = 1; i < num_threads; i++)
+            pthread_create(
+                    &threads[i].handle, NULL, helper_thread, &threads[i]);
+
+        run_playouts(&threads[0]);
+
+        stop_search = TRUE;
+        for (int i = 1; i < num_threads; i++)
+            pthread_join(threads[i].handle, NULL);
+    }
+
+    // Play the move with the most playouts: the search was sure
+    // enough to keep trying it.
+    const Mcts_node *children = &pools[current_pool][root_node->children];
+    const Mcts_node *best = &children[0];
+    for (int i = 1; i < root_node->num_children; i++)
+        if (children[i].visits > best->visits)
+            best = &children[i];
+
+    double value = best->visits ? best->score / (2.0 * best->visits) : 0.5;
+    if (!is_max)
+        value = 1 - value;
+
+    result->square = best->square;
+    result->score = lround((2 * value - 1) * MCTS_SCORE_SCALE);
+    memset(&result->counters, 0, sizeof(Search_counters));
+    for (int i = 0; i < num_threads && root_node->num_children > 1; i++)
+    {
+        result->counters.nodes += threads[i].counters.nodes;
+        result->counters.evaluations += threads[i].counters.evaluations;
+        if (threads[i].counters.max_ply > result->counters.max_ply)
+            result->counters.max_ply = threads[i].counters.max_ply;
+    }
+    result->depth = result->counters.max_ply;
+    result->counters.elapsed = get_time() - start;
+    return 1;
+}
+
+
+// Forgets the tree of the last search (for example, when a new
+// game starts).
+void clear_mcts(void)
+{
+    has_tree = FALSE;
+}
+
+
+// Allocates both pools of nodes, half of the memory each.
+//
+// Returns 1 on success and 0 if there wasn't enough memory.
+static int create_pools(int tree_size)
+{
+    size_t size = (size_t) tree_size * 1024 * 1024 / 2 / sizeof(Mcts_node);
+
+    // The children of a node must always fit.
+    if (size < 2 * NUM_SQUARES)
+        size = 2 * NUM_SQUARES;
+    if (size > UINT32_MAX)
+        size = UINT32_MAX;
+
+    pools[0] = malloc(size * sizeof(Mcts_node));
+    pools[1] = malloc(size * sizeof(Mcts_node));
+    if (!pools[0] || !pools[1])
+    {
+        free(pools[0]);
+        free(pools[1]);
+        pools[0] = pools[1] = NULL;
+        return 0;
+    }
+    pool_size = size;
+    current_pool = 0;
+    has_tree = FALSE;
+    return 1;
+}
+
+
+// Looks for a position in the tree of the last search: the root
+// itself, or a node one or two plies below (after the move of the
+// engine and the reply of the opponent).
+//
+// Returns the node, or 0 if it isn't in the tree.
+static uint32_t find_subtree(const Position *position, char is_max)
+{
+    if (
+            root_is_max == is_max &&
+            root_position.player == position->player &&
+            root_position.opponent == position->opponent)
+        return root;
+
+    const Mcts_node *root_node = &pools[current_pool][root];
+    if (root_node->state != EXPANDED)
+        return 0;
+
+    // Positions of the children are found by playing their moves
+    // on the root.
+    for (int i = 0; i < root_node->num_children; i++)
+    {
+        uint32_t child = root_node->children + i;
+        Position child_position = root_position;
+        int square = pools[current_pool][child].square;
+
+        if (square == PASS_SQUARE)
+            pass_turn(&child_position);
+        else
+            play_move(&child_position, square);
+
+        uint32_t node = find_child(
+                child, &child_position, !root_is_max, position, is_max);
+        if (node)
+            return node;
+    }
+    return 0;
+}
+
+
+// Checks a node and its children against a position.
+//
+// Arguments:
+// The node, its position and whether white is to move there.
+// The position looked for and whether white is to move there.
+//
+// Returns the node that has the position, or 0 if none has it.
+static uint32_t find_child(
+        uint32_t parent, const Position *position, char is_max,
+        const Position *target, char target_is_max)
+{
+    const Mcts_node *node = &pools[current_pool][parent];
+
+    if (
+            is_max == target_is_max &&
+            position->player == target->player &&
+            position->opponent == target->opponent)
+        return parent;
+    if (node->state != EXPANDED)
+        return 0;
+
+    for (int i = 0; i < node->num_children; i++)
+    {
+        uint32_t child = node->children + i;
+        Position child_position = *position;
+        int square = pools[current_pool][child].square;
+
+        if (square == PASS_SQUARE)
+            pass_turn(&child_position);
+        else
+            play_move(&child_position, square);
+
+        if (
+                (!is_max) == target_is_max &&
+                child_position.player == target->player &&
+                child_position.opponent == target->opponent)
+            return child;
+    }
+    return 0;
+}
+
+
+// Copies a node and everything below it to the other pool, which
+// becomes the current one, with the node as the root.
+//
+// The nodes are copied breadth first: the copied nodes are also
+// the queue of the nodes whose children are still to be copied.
+static void keep_subtree(uint32_t subtree)
+{
+    const Mcts_node *from = pools[current_pool];
+    Mcts_node *to = pools[!current_pool];
+    uint32_t next = 1;
+
+    to[next++] = from[subtree];
+    for (uint32_t i = 1; i < next; i++)
+    {
+        Mcts_node *node = &to[i];
+
+        if (node->state != EXPANDED)
+        {
+            node->state = UNEXPANDED;
+            continue;
+        }
+        memcpy(
+                &to[next], &from[node->children],
+                node->num_children * sizeof(Mcts_node));
+        node->children = next;
+        next += node->num_children;
+    }
+
+    current_pool = !current_pool;
+    nodes_used = next;
+    root = 1;
+}
+
+
+// Body of a helper thread.
+static void *helper_thread(void *argument)
+{
+    run_playouts(argument);
+    return NULL;
+}
+
+
+// Runs playouts until the search is stopped. The main thread stops
+// it when the time is over; any thread stops it when there have
+// been enough playouts.
+static void run_playouts(Mcts_thread *thread)
+{
+    while (!stop_search)
+    {
+        run_iteration(thread);
+        thread->counters.nodes++;
+        thread->counters.evaluations++;
+
+        long playouts =
+            __atomic_add_fetch(&num_playouts, 1, __ATOMIC_RELAXED);
+        if (max_playouts > 0 && playouts >= max_playouts)
+            stop_search = TRUE;
+        if (
+                thread->id == 0 &&
+                thread->counters.nodes % PLAYOUTS_PER_CLOCK_CHECK == 0 &&
+                get_time() >= deadline)
+            stop_search = TRUE;
+    }
+}
+
+
+// Goes down the tree choosing moves with UCT, expands the node it
+// gets to if it was visited before, plays the rest of the game at
+// random from there and adds the result to every node on the way.
+static void run_iteration(Mcts_thread *thread)
+{
+    Mcts_node *path[MCTS_MAX_PLY + 1];
+    Position position = root_position;
+    Mcts_node *node = &pools[current_pool][root];
+    int ply = 0;
+
+    path[0] = node;
+    __atomic_add_fetch(&node->visits, 1, __ATOMIC_RELAXED);
+
+    while (ply < MCTS_MAX_PLY)
+    {
+        if (__atomic_load_n(&node->state, __ATOMIC_ACQUIRE) != EXPANDED)
+        {
+            // The first visit only plays out the node.
+            if (
+                    __atomic_load_n(&node->visits, __ATOMIC_RELAXED) < 2 ||
+                    !expand_node(node, &position))
+                break;
+        }
+
+        // The game is over.
+        if (!node->num_children)
+            break;
+
+        node = select_child(node);
+        __atomic_add_fetch(&node->visits, 1, __ATOMIC_RELAXED);
+        if (node->square == PASS_SQUARE)
+            pass_turn(&position);
+        else
+            play_move(&position, node->square);
+        path[++ply] = node;
+    }
+    if (ply > thread->counters.max_ply)
+        thread->counters.max_ply = ply;
+
+    // The result is for the side to move at the end of the path.
+    // Every move on the way up was made by the other side of the
+    // one below.
+    int difference = play_randomly(position, &thread->random);
+    for (int i = ply; i > 0; i--)
+    {
+        difference = -difference;
+        int score = difference > 0 ? 2 : difference == 0 ? 1 : 0;
+        __atomic_add_fetch(&path[i]->score, score, __ATOMIC_RELAXED);
+    }
+}
+
+
+// Adds the children of a node: one for every valid move, one for
+// passing if there aren't any, and none if the game is over.
+//
+// Returns 1 if the node was expanded, and 0 if another thread is
+// expanding it or there is no room left in the pool.
+static int expand_node(Mcts_node *node, const Position *position)
+{
+    uint8_t state = UNEXPANDED;
+
+    if (!__atomic_compare_exchange_n(
+                &node->state, &state, EXPANDING, FALSE,
+                __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+        return state == EXPANDED;
+
+    Bitboard moves = get_valid_moves(position);
+    int num_children = count_discs(moves);
+
+    if (!num_children)
+    {
+        Position opponent = { position->opponent, position->player };
+        if (get_valid_moves(&opponent))
+            num_children = 1;
+    }
+
+    uint32_t children = num_children ? allocate_nodes(num_children) : 0;
+    if (num_children && !children)
+    {
+        __atomic_store_n(&node->state, UNEXPANDED, __ATOMIC_RELEASE);
+        return 0;
+    }
+
+    Mcts_node *child = &pools[current_pool][children];
+    for (int i = 0; i < num_children; i++)
+    {
+        memset(&child[i], 0, sizeof(Mcts_node));
+        child[i].square = moves ? pop_first_square(&moves) : PASS_SQUARE;
+    }
+    node->children = children;
+    node->num_children = num_children;
+    __atomic_store_n(&node->state, EXPANDED, __ATOMIC_RELEASE);
+    return 1;
+}
+
+
+// Chooses the child of a node with the best upper confidence
+// bound. Children that weren't visited yet go first.
+static Mcts_node *select_child(const Mcts_node *node)
+{
+    Mcts_node *children = &pools[current_pool][node->children];
+    Mcts_node *best = &children[0];
+    double best_bound = -1;
+    double log_visits = log(
+            __atomic_load_n(&node->visits, __ATOMIC_RELAXED) + 1);
+
+    for (int i = 0; i < node->num_children; i++)
+    {
+        int visits = __atomic_load_n(&children[i].visits, __ATOMIC_RELAXED);
+        int score = __atomic_load_n(&children[i].score, __ATOMIC_RELAXED);
+
+        if (!visits)
+            return &children[i];
+
+        double bound =
+            score / (2.0 * visits) +
+            EXPLORATION * sqrt(log_visits / visits);
+        if (bound > best_bound)
+        {
+            best = &children[i];
+            best_bound = bound;
+        }
+    }
+    return best;
+}
+
+
+// Plays random moves until the end of the game.
+//
+// Returns the final disc difference for the side to move in the
+// position.
+static int play_randomly(Position position, uint64_t *random)
+{
+    char same_side = TRUE;
+    char passed = FALSE;
+
+    while (TRUE)
+    {
+        Bitboard moves = get_valid_moves(&position);
+
+        if (moves)
+        {
+            play_move(&position, get_random_square(moves, random));
+            passed = FALSE;
+        }
+        else if (passed)
+            break;
+        else
+        {
+            pass_turn(&position);
+            passed = TRUE;
+        }
+        same_side = !same_side;
+    }
+
+    // Both sides passed, so the side to move is the same as before
+    // the last pass.
+    int difference =
+        count_discs(position.player) - count_discs(position.opponent);
+    return same_side ? difference : -difference;
+}
+
+
+// Returns one of the moves at random.
+static int get_random_square(Bitboard moves, uint64_t *random)
+{
+    int index = next_random(random) % count_discs(moves);
+
+    while (index-- > 0)
+        moves &= moves - 1;
+    return pop_first_square(&moves);
+}
+
+
+// Returns the next number of a xorshift* generator.
+static uint64_t next_random(uint64_t *random)
+{
+    *random ^= *random >> 12;
+    *random ^= *random << 25;
+    *random ^= *random >> 27;
+    return *random * 0x2545f4914f6cdd1dULL;
+}
+
+
+// Takes consecutive nodes from the pool.
+//
+// Returns the first one, or 0 if the pool is full.
+static uint32_t allocate_nodes(int count)
+{
+    // Once the pool is full, the count stops growing.
+    if (__atomic_load_n(&nodes_used, __ATOMIC_RELAXED) > pool_size - count)
+        return 0;
+
+    uint32_t first =
+        __atomic_fetch_add(&nodes_used, count, __ATOMIC_RELAXED);
+    if (first + (uint64_t) count > pool_size)
+        return 0;
+    memset(&pools[current_pool][first], 0, count * sizeof(Mcts_node));
+    return first;
+}
+
+
+static double get_time(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
@@ -0,0 +1,31 @@
+#ifndef _MCTS_
+#define _MCTS_
+
+#include "../bitboard/bitboard.h"
+#include "../minimax/minimax.h"
+
+// Scores of the MCTS engine go from -MCTS_SCORE_SCALE (black wins
+// every playout) to MCTS_SCORE_SCALE (white wins every playout).
+#define MCTS_SCORE_SCALE 100
+
+// Limits of a search of the MCTS engine.
+typedef struct Mcts_settings
+{
+    // Time budget, in seconds, and maximum number of playouts (0
+    // for no limit but the time).
+    double move_time;
+    long max_playouts;
+
+    // Number of threads running playouts.
+    int threads;
+
+    // Memory for the nodes of the tree, in megabytes.
+    int tree_size;
+} Mcts_settings;
+
+int search_mcts(
+        const Position *position, char is_max,
+        const Mcts_settings *settings, Search_result *result);
+void clear_mcts(void);
+
+#endif
@@ -0,0 +1,415 @@
+#include "endgame.h"
+#include "move_ordering.h"
+
+// Positions with at most this many empty squares are solved by
+// trying the empty squares directly, without generating moves.
+#define FAST_PATH_EMPTIES 4
+
+// Positions with at most this many empty squares sort their moves
+// by parity only. The ones with more empty squares are sorted
+// fastest-first, which costs more but pays off higher in the tree.
+#define PARITY_ORDER_EMPTIES 6
+
+// Positions with at least this many empty squares are stored in
+// the transposition table.
+#define TABLE_EMPTIES 8
+
+// Number of nodes searched between two calls to must_stop().
+#define NODES_PER_STOP_CHECK 4096
+
+// Score given to the move of the transposition table when sorting
+// fastest-first, so that it is always tried first.
+#define TABLE_MOVE_SCORE (1 << 20)
+
+// Weights of the fastest-first sort: every move left to the
+// opponent (corners count twice), every disc of the player next to
+// an empty square (a potential move for the opponent), and the
+// bonus of taking a corner.
+#define MOBILITY_WEIGHT 16
+#define POTENTIAL_MOBILITY_WEIGHT 4
+#define CORNER_BONUS 16
+
+// The four corners of the board.
+#define CORNERS 0x8100000000000081ULL
+
+// Solved positions are stored with their Zobrist key XORed with
+// this one, so that they never match the entries of the minimax
+// search (whose scores mean something else).
+#define ENDGAME_KEY 0x9a7c3f1e55d2b6e1ULL
+
+// The four quadrants of the board. The parity of the number of
+// empty squares in a quadrant tells who is likely to play last in
+// it, which is an advantage.
+static const Bitboard quadrants[4] =
+{
+    0x000000000f0f0f0fULL, 0x00000000f0f0f0f0ULL,
+    0x0f0f0f0f00000000ULL, 0xf0f0f0f000000000ULL
+};
+
+static int solve(
+        Endgame_search *search, const Position *position,
+        int alpha, int beta, char passed);
+static int search_move(
+        Endgame_search *search, const Position *position, int square,
+        int alpha, int beta, char first);
+static int solve_few_squares(
+        Endgame_search *search, const Position *position,
+        int alpha, int beta, const int squares[], int num_squares,
+        char passed);
+static int solve_last_square(const Position *position, int square);
+static int sort_fastest_first(
+        const Position *position, Bitboard moves, int table_move,
+        Scored_move move_list[]);
+static Bitboard get_odd_squares(Bitboard empty_squares);
+static int get_disc_difference(const Position *position);
+static char count_node(Endgame_search *search);
+
+
+// Solves a position exactly, with an alpha-beta search to the end
+// of the game.
+//
+// Scores are disc differences (the discs of the side to move minus
+// the ones of the opponent) at the end of the game, and the search
+// is fail-soft: a score not greater than alpha is an upper bound
+// of the real one, and a score not less than beta is a lower bound.
+//
+// Arguments:
+// The state of the search.
+// The position, relative to the side to move.
+// The window of the search.
+int solve_endgame(
+        Endgame_search *search, const Position *position,
+        int alpha, int beta)
+{
+    return solve(search, position, alpha, beta, 0);
+}
+
+
+// Negamax search of a position with more than FAST_PATH_EMPTIES
+// empty squares. The flag tells whether the opponent has just
+// passed, in which case the game is over if the player passes too.
+static int solve(
+        Endgame_search *search, const Position *position,
+        int alpha, int beta, char passed)
+{
+    Bitboard empty_squares = ~(position->player | position->opponent);
+    int num_empties = count_discs(empty_squares);
+
+    // Last few squares. Parity matters most here, so the squares
+    // of odd quadrants are tried first.
+    if (num_empties <= FAST_PATH_EMPTIES)
+    {
+        int squares[FAST_PATH_EMPTIES];
+        int num_squares = 0;
+        Bitboard odd_squares = get_odd_squares(empty_squares);
+        Bitboard even_squares = empty_squares & ~odd_squares;
+
+        while (odd_squares)
+            squares[num_squares++] = pop_first_square(&odd_squares);
+        while (even_squares)
+            squares[num_squares++] = pop_first_square(&even_squares);
+
+        return solve_few_squares(
+                search, position, alpha, beta, squares, num_squares,
+                passed);
+    }
+
+    if (count_node(search))
+        return 0;
+
+    Bitboard moves = get_valid_moves(position);
+
+    // The player has to pass. If the opponent passed too, the game
+    // is over.
+    if (!moves)
+    {
+        if (passed)
+            return get_disc_difference(position);
+
+        Position child = *position;
+        pass_turn(&child);
+        return -solve(search, &child, -beta, -alpha, 1);
+    }
+
+    // Use the stored result of this position, if any.
+    int table_move = NO_MOVE;
+    uint64_t key = 0;
+    if (num_empties >= TABLE_EMPTIES)
+    {
+        Transposition_entry entry;
+
+        key = hash_position(position, 1) ^ ENDGAME_KEY;
+        search->table_probes++;
+        if (probe_transposition_table(search->table, key, &entry))
+        {
+            search->table_hits++;
+            table_move = entry.best_move;
+            if (entry.bound == exact)
+                return entry.score;
+            else if (entry.bound == lower_bound && entry.score > alpha)
+                alpha = entry.score;
+            else if (entry.bound == upper_bound && entry.score < beta)
+                beta = entry.score;
+
+            if (alpha >= beta)
+                return entry.score;
+        }
+    }
+
+    int window_alpha = alpha;
+    int best_score = ENDGAME_MIN_SCORE - 1;
+    int best_move = NO_MOVE;
+    int num_tried = 0;
+
+    // Sort the moves that give the opponent fewer replies first:
+    // they lead to smaller trees and are often good.
+    if (num_empties > PARITY_ORDER_EMPTIES)
+    {
+        Scored_move move_list[NUM_SQUARES];
+        int num_moves =
+            sort_fastest_first(position, moves, table_move, move_list);
+
+        for (int i = 0; i < num_moves && best_score < beta; i++)
+        {
+            int square = select_next_move(move_list, num_moves, i);
+            num_tried++;
+            int score = search_move(
+                    search, position, square,
+                    alpha > best_score ? alpha : best_score, beta,
+                    best_move == NO_MOVE);
+            if (search->stopped)
+                return 0;
+
+            if (score > best_score)
+            {
+                best_score = score;
+                best_move = square;
+            }
+        }
+    }
+
+    // Close to the end, try the moves of odd quadrants first.
+    else
+    {
+        Bitboard odd_moves = moves & get_odd_squares(empty_squares);
+        Bitboard even_moves = moves & ~odd_moves;
+
+        while ((odd_moves || even_moves) && best_score < beta)
+        {
+            int square = pop_first_square(
+                    odd_moves ? &odd_moves : &even_moves);
+            num_tried++;
+            int score = search_move(
+                    search, position, square,
+                    alpha > best_score ? alpha : best_score, beta,
+                    best_move == NO_MOVE);
+            if (search->stopped)
+                return 0;
+
+            if (score > best_score)
+            {
+                best_score = score;
+                best_move = square;
+            }
+        }
+    }
+
+    // Count the cutoffs, and whether the first move caused them.
+    if (best_score >= beta)
+    {
+        search->cutoffs++;
+        search->first_move_cutoffs += num_tried == 1;
+    }
+
+    if (num_empties >= TABLE_EMPTIES)
+    {
+        bound bound = exact;
+        if (best_score <= window_alpha)
+            bound = upper_bound;
+        else if (best_score >= beta)
+            bound = lower_bound;
+        store_transposition_table(
+                search->table, key, num_empties, best_score, bound,
+                best_move);
+    }
+    return best_score;
+}
+
+
+// Plays a move and searches the position after it. Only the first
+// move of a node gets the whole window: the other ones are searched
+// with a null window, to prove that they aren't better than the
+// best one so far, and again with the whole window if they are.
+//
+// Returns the score of the move for the player who made it.
+static int search_move(
+        Endgame_search *search, const Position *position, int square,
+        int alpha, int beta, char first)
+{
+    Position child = *position;
+    play_move(&child, square);
+
+    if (first || beta - alpha == 1)
+        return -solve(search, &child, -beta, -alpha, 0);
+
+    int score = -solve(search, &child, -alpha - 1, -alpha, 0);
+    if (score > alpha && score < beta)
+        score = -solve(search, &child, -beta, -alpha, 0);
+    return score;
+}
+
+
+// Negamax search of the last few squares. The empty squares are
+// given in the order they are tried, and a move is valid if it
+// flips something, so no moves are generated.
+static int solve_few_squares(
+        Endgame_search *search, const Position *position,
+        int alpha, int beta, const int squares[], int num_squares,
+        char passed)
+{
+    if (num_squares == 1)
+        return solve_last_square(position, squares[0]);
+
+    if (count_node(search))
+        return 0;
+
+    int best_score = ENDGAME_MIN_SCORE - 1;
+
+    for (int i = 0; i < num_squares && best_score < beta; i++)
+    {
+        Position child = *position;
+        if (!get_flipped_discs(&child, squares[i]))
+            continue;
+        play_move(&child, squares[i]);
+
+        // The same squares, but the one just played.
+        int other_squares[FAST_PATH_EMPTIES];
+        int num_others = 0;
+        for (int j = 0; j < num_squares; j++)
+        {
+            if (j != i)
+                other_squares[num_others++] = squares[j];
+        }
+
+        int score = -solve_few_squares(
+                search, &child, -beta,
+                -(alpha > best_score ? alpha : best_score),
+                other_squares, num_others, 0);
+        if (score > best_score)
+            best_score = score;
+    }
+
+    // No valid moves. Pass, or end the game if the opponent has
+    // just passed.
+    if (best_score == ENDGAME_MIN_SCORE - 1)
+    {
+        if (passed)
+            return get_disc_difference(position);
+
+        Position child = *position;
+        pass_turn(&child);
+        return -solve_few_squares(
+                search, &child, -beta, -alpha, squares, num_squares, 1);
+    }
+    return best_score;
+}
+
+
+// Score of a position with a single empty square. Whoever can
+// play it (the player first) does, and the game is over.
+static int solve_last_square(const Position *position, int square)
+{
+    int difference = get_disc_difference(position);
+    Bitboard flipped = get_flipped_discs(position, square);
+
+    if (flipped)
+        return difference + 2 * count_discs(flipped) + 1;
+
+    Position opponent = { position->opponent, position->player };
+    flipped = get_flipped_discs(&opponent, square);
+    if (flipped)
+        return difference - 2 * count_discs(flipped) - 1;
+
+    return difference;
+}
+
+
+// Builds the list of moves with a sort score for each: the fewer
+// moves (and potential moves) the opponent has after the move, the
+// higher the score. Corners get a bonus, and the move of the
+// transposition table is always first.
+//
+// Returns the number of moves in the list.
+static int sort_fastest_first(
+        const Position *position, Bitboard moves, int table_move,
+        Scored_move move_list[])
+{
+    int num_moves = 0;
+
+    while (moves)
+    {
+        int square = pop_first_square(&moves);
+        int score;
+
+        if (square == table_move)
+            score = TABLE_MOVE_SCORE;
+        else
+        {
+            Position child = *position;
+            play_move(&child, square);
+
+            Bitboard replies = get_valid_moves(&child);
+            Bitboard empty_squares = ~(child.player | child.opponent);
+            Bitboard frontier =
+                child.opponent & get_neighbours(empty_squares);
+
+            score = -MOBILITY_WEIGHT * (
+                    count_discs(replies) + count_discs(replies & CORNERS)) -
+                POTENTIAL_MOBILITY_WEIGHT * count_discs(frontier);
+            if (SQUARE_BIT(square) & CORNERS)
+                score += CORNER_BONUS;
+        }
+
+        move_list[num_moves].square = square;
+        move_list[num_moves].score = score;
+        num_moves++;
+    }
+    return num_moves;
+}
+
+
+// Returns the empty squares of the quadrants that have an odd
+// number of them.
+static Bitboard get_odd_squares(Bitboard empty_squares)
+{
+    Bitboard odd_squares = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        Bitboard squares = empty_squares & quadrants[i];
+        if (count_discs(squares) % 2)
+            odd_squares |= squares;
+    }
+    return odd_squares;
+}
+
+
+// Discs of the side to move minus the ones of the opponent.
+static int get_disc_difference(const Position *position)
+{
+    return count_discs(position->player) - count_discs(position->opponent);
+}
+
+
+// Counts a node, and checks every now and then whether the search
+// has to stop.
+//
+// Returns whether the search has stopped.
+static char count_node(Endgame_search *search)
+{
+    if (
+            ++search->nodes % NODES_PER_STOP_CHECK == 0 &&
+            search->must_stop())
+        search->stopped = 1;
+    return search->stopped;
+}
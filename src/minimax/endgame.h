@@ -0,0 +1,41 @@
+#ifndef _ENDGAME_
+#define _ENDGAME_
+
+#include "../bitboard/bitboard.h"
+#include "transposition.h"
+
+// Default number of empty squares from which the game is solved
+// exactly.
+#define DEFAULT_ENDGAME_EMPTIES 18
+
+// Highest and lowest possible scores of a solved game.
+#define ENDGAME_MAX_SCORE NUM_SQUARES
+#define ENDGAME_MIN_SCORE -NUM_SQUARES
+
+// State of a search of the endgame solver.
+typedef struct Endgame_search
+{
+    // Table to store the solved positions (shared with the rest of
+    // the search engine).
+    Transposition_table *table;
+
+    // Nodes visited so far, probes of the table and how many found
+    // the position, and cutoffs (and how many the first move tried
+    // caused).
+    unsigned long nodes;
+    unsigned long table_probes;
+    unsigned long table_hits;
+    unsigned long cutoffs;
+    unsigned long first_move_cutoffs;
+
+    // Called every now and then. When it returns true, the search
+    // stops and its result is meaningless.
+    char (*must_stop)(void);
+    char stopped;
+} Endgame_search;
+
+int solve_endgame(
+        Endgame_search *search, const Position *position,
+        int alpha, int beta);
+
+#endif
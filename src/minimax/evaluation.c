@@ -0,0 +1,315 @@
+#include <stdio.h>
+#include "evaluation.h"
+
+// Number of diagonals of the board in each direction.
+#define NUM_DIAGONALS 15
+
+// Maximum length of a line of a weights file.
+#define MAX_LINE_LENGTH 256
+
+// Masks for the columns at the edges of the board, to drop the
+// discs that a shift moves from one row to the next.
+#define NOT_COLUMN_A 0xfefefefefefefefeULL
+#define NOT_COLUMN_H 0x7f7f7f7f7f7f7f7fULL
+
+// Squares at the edges of the board for each direction: a disc
+// there can't be flanked along that direction.
+#define COLUMNS_A_H 0x8181818181818181ULL
+#define ROWS_1_8 0xff000000000000ffULL
+#define EDGES 0xff818181818181ffULL
+
+// First square of every row and every column.
+#define FIRST_COLUMN 0x0101010101010101ULL
+#define FIRST_ROW 0x00000000000000ffULL
+
+// The four corners, and the X-square diagonally next to each of
+// them (in the same order).
+static const int corner_squares[4] = {0, 7, 56, 63};
+static const int corner_x_squares[4] = {9, 14, 49, 54};
+
+// Squares of every diagonal of the board, in both directions
+// (along A1-H8 and along H1-A8).
+static Bitboard diagonals[NUM_DIAGONALS];
+static Bitboard anti_diagonals[NUM_DIAGONALS];
+
+// Weights tuned by hand, from the opening (first row) to the end
+// of the game (last row).
+static const Phase_weights default_weights[NUM_PHASES] = {
+    {10, 5, -4, 10, 0, 80, -40, -1},
+    {12, 5, -5, 15, 0, 80, -40, 0},
+    {10, 4, -4, 20, 10, 70, -30, 2},
+    {6, 2, -2, 25, 20, 50, -15, 6}
+};
+
+static int evaluate_side(
+        Bitboard discs, Bitboard empty_squares, const Phase_weights *weights);
+static Bitboard get_full_lines_horizontal(Bitboard occupied);
+static Bitboard get_full_lines_vertical(Bitboard occupied);
+static Bitboard get_full_lines(
+        Bitboard occupied, const Bitboard *lines, int num_lines);
+static int parse_phase_weights(const char *line, Phase_weights *weights);
+
+
+// Precomputes the diagonals used to find stable discs. Must be
+// called once before evaluate_position().
+void init_evaluation(void)
+{
+    for (int i = 0; i < NUM_DIAGONALS; i++)
+    {
+        diagonals[i] = 0;
+        anti_diagonals[i] = 0;
+    }
+
+    // Along a diagonal, the difference between the column and the
+    // row is the same, and along an anti-diagonal, their sum.
+    for (int square = 0; square < NUM_SQUARES; square++)
+    {
+        int row = square / BOARD_WIDTH;
+        int column = square % BOARD_WIDTH;
+
+        diagonals[column - row + BOARD_WIDTH - 1] |= SQUARE_BIT(square);
+        anti_diagonals[column + row] |= SQUARE_BIT(square);
+    }
+}
+
+
+void set_default_weights(Evaluation_weights *weights)
+{
+    for (int i = 0; i < NUM_PHASES; i++)
+        weights->phases[i] = default_weights[i];
+}
+
+
+// Reads the weights of the evaluation from a text file.
+//
+// The file has a line for every phase of the game, from the opening
+// to the end, with the weights of the features in the order of
+// Phase_weights. Empty lines and lines starting with '#' are
+// skipped.
+//
+// Returns 1 on success and 0 if the file couldn't be read or
+// doesn't have the weights of every phase (the weights are left
+// untouched then).
+int load_weights(const char *path, Evaluation_weights *weights)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return 0;
+
+    Evaluation_weights read_weights;
+    char line[MAX_LINE_LENGTH];
+    int num_phases = 0;
+
+    while (fgets(line, sizeof(line), file))
+    {
+        // Skip the blanks at the start of the line.
+        const char *start = line;
+        while (*start == ' ' || *start == '\t')
+            start++;
+        if (*start == '#' || *start == '\n' || *start == '\0')
+            continue;
+
+        if (
+                num_phases == NUM_PHASES ||
+                !parse_phase_weights(
+                    start, &read_weights.phases[num_phases]))
+        {
+            fclose(file);
+            return 0;
+        }
+        num_phases++;
+    }
+    fclose(file);
+
+    if (num_phases < NUM_PHASES)
+        return 0;
+    *weights = read_weights;
+    return 1;
+}
+
+
+// Reads the weights of a phase from a line of a weights file.
+//
+// Returns 1 if the line has exactly the weights of every feature.
+static int parse_phase_weights(const char *line, Phase_weights *weights)
+{
+    int extra;
+
+    return sscanf(
+            line, "%d %d %d %d %d %d %d %d %d",
+            &weights->mobility, &weights->potential_mobility,
+            &weights->frontier, &weights->stability, &weights->parity,
+            &weights->corners, &weights->x_squares, &weights->discs,
+            &extra) == NUM_FEATURES;
+}
+
+
+// Heuristic score of a position that isn't finished.
+//
+// Arguments:
+// The position, relative to the side to move.
+// The weights of the features.
+//
+// Returns the score of the position for the side to move (the
+// greater, the better for it).
+int evaluate_position(
+        const Position *position, const Evaluation_weights *weights)
+{
+    Bitboard empty_squares = ~(position->player | position->opponent);
+    int empties = count_discs(empty_squares);
+    const Phase_weights *phase_weights =
+        &weights->phases[get_game_phase(empties)];
+
+    // Valid moves of both sides.
+    Position opponent_position = {position->opponent, position->player};
+    int mobility =
+        count_discs(get_valid_moves(position)) -
+        count_discs(get_valid_moves(&opponent_position));
+
+    // Without passes, the side to move plays the last move when
+    // the number of empty squares is odd.
+    int parity = empties % 2 ? 1 : -1;
+
+    return
+        phase_weights->mobility * mobility +
+        phase_weights->parity * parity +
+        evaluate_side(position->player, empty_squares, phase_weights) -
+        evaluate_side(position->opponent, empty_squares, phase_weights);
+}
+
+
+// Returns the phase of the game (the row of the weights) for a
+// number of empty squares.
+int get_game_phase(int empties)
+{
+    int moves_played = NUM_SQUARES - 4 - empties;
+    int phase = moves_played * NUM_PHASES / (NUM_SQUARES - 4);
+
+    if (phase >= NUM_PHASES)
+        return NUM_PHASES - 1;
+    return phase;
+}
+
+
+// Adds up the features of the discs of one side that don't
+// depend on whose turn it is.
+static int evaluate_side(
+        Bitboard discs, Bitboard empty_squares, const Phase_weights *weights)
+{
+    Bitboard occupied = ~empty_squares;
+
+    // Empty squares next to the other side's discs, where this side
+    // may be able to play later on.
+    Bitboard other_discs = occupied & ~discs;
+    int potential_mobility =
+        count_discs(get_neighbours(other_discs) & empty_squares);
+
+    int frontier = count_discs(discs & get_neighbours(empty_squares));
+    int stability = count_discs(get_stable_discs(discs, occupied));
+
+    // An X-square gives the corner away while the corner is empty.
+    int corners = 0;
+    int x_squares = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        if (discs & SQUARE_BIT(corner_squares[i]))
+            corners++;
+        else if (
+                (empty_squares & SQUARE_BIT(corner_squares[i])) &&
+                (discs & SQUARE_BIT(corner_x_squares[i])))
+            x_squares++;
+    }
+
+    return
+        weights->potential_mobility * potential_mobility +
+        weights->frontier * frontier +
+        weights->stability * stability +
+        weights->corners * corners +
+        weights->x_squares * x_squares +
+        weights->discs * count_discs(discs);
+}
+
+
+// Finds the discs of a side that can't be flipped for the rest of
+// the game.
+//
+// A disc is stable when, along each of the four directions, either
+// the line is full, or the disc is at the edge of the board or next
+// to a stable disc of its own side. Starting from nothing, the
+// stable discs are added until none can be found.
+//
+// Arguments:
+// The discs of the side.
+// The occupied squares of the board.
+//
+// Returns the stable discs.
+Bitboard get_stable_discs(Bitboard discs, Bitboard occupied)
+{
+    // Discs that can't be flanked along each direction because
+    // their whole line is full or they are at the edge.
+    Bitboard horizontal = get_full_lines_horizontal(occupied) | COLUMNS_A_H;
+    Bitboard vertical = get_full_lines_vertical(occupied) | ROWS_1_8;
+    Bitboard diagonal =
+        get_full_lines(occupied, diagonals, NUM_DIAGONALS) | EDGES;
+    Bitboard anti_diagonal =
+        get_full_lines(occupied, anti_diagonals, NUM_DIAGONALS) | EDGES;
+
+    Bitboard stable = 0;
+    Bitboard new_stable = discs & horizontal & vertical &
+        diagonal & anti_diagonal;
+
+    while (new_stable & ~stable)
+    {
+        stable |= new_stable;
+
+        // A stable disc protects its neighbours along its
+        // direction.
+        new_stable = discs &
+            (horizontal |
+             ((stable << 1) & NOT_COLUMN_A) |
+             ((stable >> 1) & NOT_COLUMN_H)) &
+            (vertical | (stable << 8) | (stable >> 8)) &
+            (diagonal |
+             ((stable << 9) & NOT_COLUMN_A) |
+             ((stable >> 9) & NOT_COLUMN_H)) &
+            (anti_diagonal |
+             ((stable << 7) & NOT_COLUMN_H) |
+             ((stable >> 7) & NOT_COLUMN_A));
+    }
+    return stable;
+}
+
+
+// Returns the squares of the rows that are full.
+static Bitboard get_full_lines_horizontal(Bitboard occupied)
+{
+    // After the shifts, the first square of a row is set only if
+    // the eight squares of the row are occupied.
+    Bitboard full = occupied & (occupied >> 1);
+    full &= full >> 2;
+    full &= full >> 4;
+    return (full & FIRST_COLUMN) * FIRST_ROW;
+}
+
+
+// Returns the squares of the columns that are full.
+static Bitboard get_full_lines_vertical(Bitboard occupied)
+{
+    Bitboard full = occupied & (occupied >> 8);
+    full &= full >> 16;
+    full &= full >> 32;
+    return (full & FIRST_ROW) * FIRST_COLUMN;
+}
+
+
+// Returns the squares of the given lines that are full.
+static Bitboard get_full_lines(
+        Bitboard occupied, const Bitboard *lines, int num_lines)
+{
+    Bitboard full = 0;
+
+    for (int i = 0; i < num_lines; i++)
+        if ((occupied & lines[i]) == lines[i])
+            full |= lines[i];
+    return full;
+}
@@ -0,0 +1,57 @@
+#ifndef _EVALUATION_
+#define _EVALUATION_
+
+#include "../bitboard/bitboard.h"
+
+// Number of phases of the game with weights of their own. The
+// phase of a position depends on its number of empty squares.
+#define NUM_PHASES 4
+
+// Number of weights of a phase.
+#define NUM_FEATURES 8
+
+// Weights of the features of the evaluation in a phase of the
+// game. Every feature is the difference between the side to move
+// and the opponent.
+typedef struct Phase_weights
+{
+    // Valid moves, and empty squares next to the other side's
+    // discs (moves that could become valid later).
+    int mobility;
+    int potential_mobility;
+
+    // Discs next to an empty square.
+    int frontier;
+
+    // Discs that can't be flipped anymore.
+    int stability;
+
+    // Whether the side gets the last move of the game (1 or -1 for
+    // the side to move).
+    int parity;
+
+    // Corners, and X-squares (diagonally next to a corner) while
+    // their corner is empty.
+    int corners;
+    int x_squares;
+
+    // Discs.
+    int discs;
+} Phase_weights;
+
+// Weights of the evaluation, for every phase of the game (from the
+// opening to the end).
+typedef struct Evaluation_weights
+{
+    Phase_weights phases[NUM_PHASES];
+} Evaluation_weights;
+
+void init_evaluation(void);
+void set_default_weights(Evaluation_weights *weights);
+int load_weights(const char *path, Evaluation_weights *weights);
+int evaluate_position(
+        const Position *position, const Evaluation_weights *weights);
+Bitboard get_stable_discs(Bitboard discs, Bitboard occupied);
+int get_game_phase(int empties);
+
+#endif
@@ -1,5 +1,15 @@
-#include "../input_output/game_io.h"
-#include "../logic/logic.h"
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "minimax.h"
+#include "transposition.h"
+#include "move_ordering.h"
+#include "endgame.h"
+#include "../book/book.h"
+#include "../mcts/mcts.h"
 
 // Minimizer has won.
 #define MIN_SCORE -10000
@@ -7,359 +17,1186 @@
 // Maximizer has won.
 #define MAX_SCORE 10000
 
-// Maximum recursion depth.
-// Previous 4.
-#define MAX_DEPTH 4
+// Maximum depth of an iteration (one ply per square). The
+// search stops earlier when it runs out of time.
+#define MAX_DEPTH 60
+
+// When the endgame is solved, the iterations before the one that
+// solves it stop at this depth. They are quick, sort the root moves
+// and give a move to play if the solver runs out of time.
+#define ENDGAME_PRESEARCH_DEPTH 6
+
+// Number of nodes searched between two checks of the clock.
+#define NODES_PER_CLOCK_CHECK 1024
 
 // Huge number used as a starting value when
 // finding the maximum and minimum scores.
 #define HUGE_NUMBER 1000000
 
-// Score associated with controlling a corner of the
-// board (should always be greater than MAX_DEPTH).
-#define CORNER_VALUE 30
+// Greatest heuristic score of a position, kept well below the
+// scores of won games so that both are never confused.
+#define MAX_EVALUATION (MAX_SCORE / 2)
+
+// Half the width of the aspiration window of an iteration, around
+// the score of the previous one. It doubles every time the score
+// falls out of the window. The iterations before ASPIRATION_DEPTH
+// get the whole window.
+#define ASPIRATION_WINDOW 16
+#define ASPIRATION_DEPTH 4
+
+// What a move changed in the position being searched, to take it
+// back: the square and the flipped discs, and the side to move and
+// Zobrist key before the move. The flag tells whether the move made
+// the opponent pass.
+typedef struct Undo_record
+{
+    int square;
+    Bitboard flipped;
+    uint64_t hash;
+    char is_max;
+    char passed;
+} Undo_record;
 
+// State of one of the threads of the search.
+//
+// Every thread searches the same root on its own, with its own
+// killer moves and history. The threads only share the
+// transposition table (and the flag that stops the search). Each
+// one starts on its own cache line, so that the counters that a
+// thread updates at every node don't share a line with the
+// previous thread.
+typedef struct __attribute__((aligned(64))) Search_thread
+{
+    // Number of the thread. The main thread is number 0.
+    int id;
+    pthread_t handle;
+
+    // Position at the root of the search and its moves, sorted by
+    // the scores of the last iteration.
+    Position root;
+    uint64_t hash;
+    char is_max;
+    Scored_move root_moves[NUM_SQUARES];
+    int num_moves;
+    int num_empties;
+
+    // Position of the node being searched. Moves are made on it and
+    // taken back, and the undo stack has a record for each move
+    // made since the root.
+    Position position;
+    uint64_t position_hash;
+    char position_is_max;
+    Undo_record undo_stack[MAX_PLY];
+    int ply;
+
+    // Indices of the patterns of the position, kept up to date
+    // while there are pattern tables.
+    Pattern_indices pattern_indices;
+
+    // Accumulators of the network for the positions of the undo
+    // stack (the one of the root first), while there is a network.
+    Nnue_accumulator accumulators[MAX_PLY + 1];
+
+    // Whether the thread is running the shallow search of ProbCut,
+    // which doesn't prune again.
+    char in_probcut;
+
+    // Depth of the iteration being searched, depth and score of
+    // the last iteration that was completed.
+    int search_depth;
+    int completed_depth;
+    int best_score;
+
+    // What the thread did during the search.
+    Search_counters counters;
+
+    // Killer moves and history of the thread.
+    Move_ordering ordering;
+} Search_thread;
+
+// Table of the positions searched so far, shared by all the
+// threads. It is kept from one move to the next.
+static Transposition_table table;
+
+// The threads of the search, and how many of them are used.
+static Search_thread threads[MAX_THREADS];
+static int num_threads;
+
+// Time budget of every move, in seconds, and maximum depth of the
+// search (0 for no limit).
+static double move_time;
+static int max_depth;
+
+// Number of empty squares from which the endgame is solved.
+static int endgame_empties;
+
+// Engine that searches before the endgame, and the limits of the
+// MCTS engine.
+static char engine;
+static Mcts_settings mcts_settings;
+
+// Weights of the evaluation of the positions, and the pattern
+// tables or the network that replace them if there are any.
+static Evaluation_weights weights;
+static const Pattern_tables *pattern_tables;
+static const Nnue_network *network;
+
+// Calibration of ProbCut, if it prunes.
+static const Probcut_parameters *probcut;
+
+// Opening book, if there is one.
+static Book book;
+
+// Time budget of the current search, time when it has to stop,
+// and whether it has already stopped. Only the main thread checks
+// the clock; the helper threads stop when it tells them to.
+static double time_limit;
+static double deadline;
+static volatile char stop_search;
+
+// Whether the engine ponders (searches while the opponent thinks),
+// and the thread and position of the search when it does.
+static char ponder_enabled;
+static char pondering;
+static pthread_t ponder_thread;
+static Position ponder_position;
+static char ponder_is_max;
+
+static void run_search(
+        const Position *position, char is_max, Search_result *result);
+static void *ponder_main(void *argument);
+static void *helper_thread(void *argument);
+static void iterate(Search_thread *thread, int first_depth, int last_depth);
+static int get_next_depth(const Search_thread *thread, int depth);
+static int get_last_depth(int num_empties);
+static int search_root(Search_thread *thread);
+static int search_root_window(Search_thread *thread, int alpha, int beta);
+static int solve_root(Search_thread *thread);
+static int solve_move(
+        Endgame_search *search, const Position *child, char same_player,
+        int alpha, int beta);
+static int solved_score(int difference, char is_max);
+static char check_clock(void);
+static char is_search_stopped(void);
+static void sort_root_moves(Scored_move root_moves[], int num_moves);
+static void add_counters(
+        Search_counters *total, const Search_counters *counters);
+static double get_time(void);
 static int min(int a, int b);
 static int max(int a, int b);
-static int minimax(
-        Game *game, int depth, char is_max, int alpha, int beta);
-static int evaluate(Game *game);
-static int evaluate_corners(Game *game);
+static int search_child(
+        Search_thread *thread, int depth, int alpha, int beta, char is_max,
+        char first_move);
+static int negamax(Search_thread *thread, int depth, int alpha, int beta);
+static char try_probcut(
+        Search_thread *thread, int depth, int beta, int *score);
+static int evaluate(const Position *position, char is_max);
+static int evaluate_heuristic(const Search_thread *thread);
+static void start_from_root(Search_thread *thread);
+static void make_move(Search_thread *thread, int square);
+static void unmake_move(Search_thread *thread);
+
+
+// Sets up the search engine. Must be called once before
+// search_position().
+//
+// Returns 1 on success and 0 if the transposition table couldn't
+// be allocated.
+int init_search(const Search_options *options)
+{
+    init_evaluation();
+    init_patterns();
+    set_search_options(options);
+    mcts_settings.tree_size = options->hash_size;
+    init_zobrist_keys();
+    if (!create_transposition_table(&table, options->hash_size))
+        return 0;
+    clear_search();
+
+    // Without the opening book, every move is searched.
+    if (options->book_path && !open_book(&book, options->book_path))
+        fprintf(
+                stderr, "Could not open the opening book %s.\n",
+                options->book_path);
+    return 1;
+}
+
+
+// Changes the settings of the search that don't need to set
+// anything up: the time budget, the depth, the threads, the
+// endgame, pondering, the evaluation, ProbCut and the engine. The size of
+// the transposition table (and of the MCTS tree) and the opening
+// book stay the ones given to init_search().
+void set_search_options(const Search_options *options)
+{
+    move_time = options->move_time;
+    max_depth = options->max_depth;
+    ponder_enabled = options->ponder;
+    endgame_empties = options->endgame_empties;
+    set_search_threads(options->threads);
+
+    if (options->weights)
+        weights = *options->weights;
+    else
+        set_default_weights(&weights);
+    pattern_tables = options->patterns;
+    network = options->network;
+    probcut = options->probcut;
+
+    engine = options->engine;
+    mcts_settings.move_time = options->move_time;
+    mcts_settings.max_playouts = options->max_playouts;
+}
+
+
+// Changes the number of threads used by the search (at least 1
+// and at most MAX_THREADS), with either engine.
+void set_search_threads(int count)
+{
+    num_threads = min(max(count, 1), MAX_THREADS);
+    mcts_settings.threads = num_threads;
+}
 
 
-// Finds the best move possible in this board configuration
-// using the Minimax algorithm.
+// Forgets everything learned in previous searches (for example,
+// when a new game starts).
+void clear_search(void)
+{
+    stop_pondering();
+    clear_mcts();
+    clear_transposition_table(&table);
+    for (int i = 0; i < MAX_THREADS; i++)
+        clear_move_ordering(&threads[i].ordering);
+}
+
+
+// Looks up a position in the opening book (if there is one).
 //
 // Arguments:
-// The game struct, which represents the state of the game.
-// A "move" struct to store the best possible move.
+// The position and a variable to store the move of the book.
 //
-// Returns the minimax score of the best possible move,
-// being black the minimizer and white the maximizer.
-int find_best_move(Game *game, Move *move)
+// Returns 1 if the position is in the book and 0 otherwise.
+int probe_opening_book(const Position *position, int *square)
 {
-    char is_max;
-    int best_score;
+    return book.entries && probe_book(&book, position, square);
+}
 
-    // Auxiliary variable to store the tentative moves on
-    // each node.
-    Move aux_move;
 
-    // Find out if the player is the minimizer or the
-    // maximizer.
-    if (get_players_color(*game) == black)
-        is_max = 0;
-    else
-        is_max = 1;
+// Searches a position (which must have at least one valid move)
+// within the time budget of a move.
+//
+// The search is iterative: it searches 1 ply deep, then 2, 3...
+// until the time budget of the move runs out, and keeps the
+// result of the last iteration that was completed. Each iteration
+// tries the root moves in the order given by the scores of the
+// previous one. Below the root, the moves are tried best-first
+// (see move_ordering.c).
+//
+// When there are several threads, the helper threads search the
+// same position at the same time (half of them one ply deeper
+// than the main thread) and fill the shared transposition table,
+// which the main thread uses to search faster. The result is the
+// one of the main thread.
+//
+// If the engine was pondering, the pondering stops, and what it
+// found is used through the transposition table.
+//
+// Arguments:
+// The position and whether the side to move is the maximizer.
+// A struct to store the result of the search.
+//
+// Returns the minimax score of the best move.
+int search_position(
+        const Position *position, char is_max, Search_result *result)
+{
+    stop_pondering();
+
+    // Before the endgame, the MCTS engine searches instead if it was
+    // chosen (and its tree could be allocated).
+    int empty_squares =
+        NUM_SQUARES - count_discs(position->player | position->opponent);
+    if (
+            engine == ENGINE_MCTS && empty_squares > endgame_empties &&
+            search_mcts(position, is_max, &mcts_settings, result))
+        return result->score;
+
+    time_limit = move_time;
+    deadline = get_time() + move_time;
+    stop_search = FALSE;
+    run_search(position, is_max, result);
+    return result->score;
+}
 
-    // Save the state of the game before trying a move.
-    Game game_copy = (*game);
 
-    // Try every valid move possible and save the one
-    // that generates the best outcome of the player.
-    // Minimizer's turn (black discs).
-    if (!is_max)
+// Starts searching, in the background, the position where the
+// opponent is to move, if pondering is enabled. It searches every
+// reply of the opponent at once, so whatever the reply is, the
+// positions after it are in the transposition table when the
+// engine's turn comes.
+//
+// The search goes on until stop_pondering() is called (or until
+// it reaches the end of the game).
+void start_pondering(const Position *position, char is_max)
+{
+    // The MCTS engine doesn't ponder: it keeps its tree from one
+    // move to the next instead.
+    if (
+            !ponder_enabled || engine == ENGINE_MCTS ||
+            !get_valid_moves(position))
+        return;
+
+    stop_pondering();
+    ponder_position = *position;
+    ponder_is_max = is_max;
+
+    // The search has no deadline.
+    time_limit = DBL_MAX;
+    deadline = DBL_MAX;
+    stop_search = FALSE;
+    pondering = TRUE;
+    pthread_create(&ponder_thread, NULL, ponder_main, NULL);
+}
+
+
+// Stops the pondering search, if there is one, and waits for it to
+// finish.
+void stop_pondering(void)
+{
+    if (!pondering)
+        return;
+
+    stop_search = TRUE;
+    pthread_join(ponder_thread, NULL);
+    pondering = FALSE;
+}
+
+
+// Body of the pondering thread.
+static void *ponder_main(void *argument)
+{
+    Search_result result;
+
+    (void) argument;
+    run_search(&ponder_position, ponder_is_max, &result);
+    return NULL;
+}
+
+
+// Searches a position with every thread until the search is
+// stopped, the deadline passes or the search reaches the end of
+// the game (see search_position()). The deadline and the stop flag
+// must be set before.
+static void run_search(
+        const Position *position, char is_max, Search_result *result)
+{
+    Scored_move root_moves[NUM_SQUARES];
+    Transposition_entry entry;
+    uint64_t hash = hash_position(position, is_max);
+
+    // The entries of the previous searches become older than the
+    // ones of this search.
+    start_table_generation(&table);
+
+    // List every valid move. Before the first iteration, they are
+    // sorted like the moves of any other node.
+    age_move_ordering(&threads[0].ordering);
+    int num_moves = score_moves(
+            &threads[0].ordering, get_valid_moves(position),
+            probe_transposition_table(&table, hash, &entry) ?
+            entry.best_move : NO_MOVE,
+            0, is_max, root_moves);
+    sort_root_moves(root_moves, num_moves);
+
+    int empty_squares =
+        NUM_SQUARES - count_discs(position->player | position->opponent);
+    int last_depth = get_last_depth(empty_squares);
+
+    // Set every thread up with the same root.
+    for (int i = 0; i < num_threads; i++)
     {
-        best_score = HUGE_NUMBER;
-        for (int i = 0; i < BOARD_SIZE; i++)
-        {
-            for (int j = 0; j < BOARD_SIZE; j++)
-            {
-                if ((*game).board[i][j].status == valid)
-                {
-                    // Save the move.
-                    aux_move.column = j;
-                    aux_move.row = i;
-
-                    // Make the move and transform the board.
-                    transform_board(game, aux_move);
-
-                    // If there are valid moves, switch the player.
-                    if (check_for_valid_moves(game))
-                    {
-                        switch_player(&game->turn);
-                        is_max = !is_max;
-                    }
-
-                    // If there aren't valid moves, the next player
-                    // has to pass its turn and we don't switch players.
-                    else
-                    {
-                        // Mark all squares where the next move could be made.
-                        mark_valid_moves(game, get_players_color(*game));
-                    }
-
-                    // Calculate the score for this move.
-                    int move_score =
-                        minimax(game, 0, is_max, -HUGE_NUMBER, HUGE_NUMBER);
-
-                    // If this move produces a better (lower) score
-                    // than the current best score, this is the new
-                    // best move.
-                    if (best_score > move_score)
-                    {
-                        (*move).row = i;
-                        (*move).column = j;
-                        best_score = move_score;
-                    }
-
-                    // Undo the move.
-                    (*game) = game_copy;
-                }
-            }
-        }
+        Search_thread *thread = &threads[i];
+
+        thread->id = i;
+        thread->root = *position;
+        thread->hash = hash;
+        thread->is_max = is_max;
+        thread->num_moves = num_moves;
+        thread->num_empties = empty_squares;
+        for (int j = 0; j < num_moves; j++)
+            thread->root_moves[j] = root_moves[j];
+        thread->in_probcut = FALSE;
+        thread->completed_depth = 0;
+        thread->best_score = 0;
+        memset(&thread->counters, 0, sizeof(Search_counters));
+        if (i > 0)
+            age_move_ordering(&thread->ordering);
     }
 
-    // Maximizer's turn (white discs).
-    else
+    // Start the helper threads.
+    double start = get_time();
+    for (int i = 1; i < num_threads; i++)
+        pthread_create(&threads[i].handle, NULL, helper_thread, &threads[i]);
+
+    iterate(&threads[0], 1, last_depth);
+
+    // Stop the helper threads.
+    stop_search = TRUE;
+    for (int i = 1; i < num_threads; i++)
+        pthread_join(threads[i].handle, NULL);
+
+    result->square = threads[0].root_moves[0].square;
+    result->score = threads[0].best_score;
+    result->depth = threads[0].completed_depth;
+    memset(&result->counters, 0, sizeof(Search_counters));
+    for (int i = 0; i < num_threads; i++)
+        add_counters(&result->counters, &threads[i].counters);
+    result->counters.elapsed = get_time() - start;
+}
+
+
+// Returns the fraction of the cutoffs that the first move tried
+// caused (0 if there were no cutoffs).
+double get_first_move_cutoff_rate(const Search_counters *counters)
+{
+    if (!counters->cutoffs)
+        return 0;
+    return (double) counters->first_move_cutoffs / counters->cutoffs;
+}
+
+
+// Returns the fraction of the probes of the transposition table
+// that found the position (0 if there were no probes).
+double get_table_hit_rate(const Search_counters *counters)
+{
+    if (!counters->table_probes)
+        return 0;
+    return (double) counters->table_hits / counters->table_probes;
+}
+
+
+// Body of a helper thread. Odd helpers start one ply deeper than
+// the main thread, so that the threads don't all search the same
+// depth at the same time.
+static void *helper_thread(void *argument)
+{
+    Search_thread *thread = argument;
+
+    iterate(
+            thread, 1 + thread->id % 2,
+            get_last_depth(thread->num_empties));
+    return NULL;
+}
+
+
+// Iterative deepening loop of a thread: searches the root at
+// every depth between the given ones, until the search is
+// stopped.
+static void iterate(Search_thread *thread, int first_depth, int last_depth)
+{
+    double start = get_time();
+
+    for (
+            thread->search_depth = first_depth;
+            thread->search_depth <= last_depth;
+            thread->search_depth = get_next_depth(
+                thread, thread->search_depth))
     {
-        best_score = -HUGE_NUMBER;
-        for (int i = 0; i < BOARD_SIZE; i++)
+        int score = search_root(thread);
+
+        // The iteration ran out of time. Keep the previous one.
+        if (stop_search)
+            break;
+
+        // The best move is now the first one of the list.
+        thread->best_score = score;
+        thread->completed_depth = thread->search_depth;
+
+        // The main thread doesn't start another iteration if
+        // there's nothing to choose, or if more than half of the
+        // time is gone (the next iteration wouldn't finish). The
+        // endgame solver is always given a chance, though.
+        if (
+                thread->id == 0 &&
+                (thread->num_moves == 1 ||
+                 (get_time() - start > time_limit / 2 &&
+                  get_next_depth(thread, thread->search_depth) !=
+                  thread->num_empties)))
+            break;
+    }
+}
+
+
+// Returns the depth of the iteration that follows the one of the
+// given depth. When there are few empty squares left, the search
+// jumps to the end of the game after a few iterations.
+static int get_next_depth(const Search_thread *thread, int depth)
+{
+    if (
+            thread->num_empties <= endgame_empties &&
+            depth >= ENDGAME_PRESEARCH_DEPTH)
+        return max(depth + 1, thread->num_empties);
+    return depth + 1;
+}
+
+
+// Returns the depth of the last iteration. No iteration can go
+// deeper than the end of the game, nor than the maximum depth
+// (unless the endgame is solved: the solver goes to the end).
+static int get_last_depth(int num_empties)
+{
+    if (max_depth > 0 && num_empties > endgame_empties)
+        return min(min(num_empties, MAX_DEPTH), max_depth);
+    return min(num_empties, MAX_DEPTH);
+}
+
+
+// Searches every root move to the depth of the current iteration
+// and sorts the list by the new scores (best move first).
+//
+// The moves are searched with a narrow window around the score of
+// the previous iteration (an aspiration window), which is widened
+// on the side the score falls out of until the score is inside.
+//
+// Returns the score of the best move. If the search is stopped,
+// the return value is meaningless.
+static int search_root(Search_thread *thread)
+{
+    // The iteration goes to the end of the game. It's much faster
+    // to solve it.
+    if (thread->search_depth == thread->num_empties)
+        return solve_root(thread);
+
+    // The window is for the player at the root.
+    int sign = thread->is_max ? 1 : -1;
+    int previous_score = sign * thread->best_score;
+    int delta = ASPIRATION_WINDOW;
+    int alpha = -HUGE_NUMBER;
+    int beta = HUGE_NUMBER;
+
+    // The first iterations are too unstable, and the score of a won
+    // game can't be guessed.
+    if (
+            thread->completed_depth >= ASPIRATION_DEPTH &&
+            previous_score >= -MAX_EVALUATION &&
+            previous_score <= MAX_EVALUATION)
+    {
+        alpha = previous_score - delta;
+        beta = previous_score + delta;
+    }
+
+    while (TRUE)
+    {
+        int score = search_root_window(thread, alpha, beta);
+
+        if (stop_search)
+            return 0;
+
+        if (score <= alpha)
+            alpha = max(score - delta, -HUGE_NUMBER);
+        else if (score >= beta)
+            beta = min(score + delta, HUGE_NUMBER);
+        else
+            return sign * score;
+        delta *= 2;
+    }
+}
+
+
+// Searches the root moves, in the order of the list, with a window
+// for the player at the root (see search_child()).
+//
+// If the best score is inside the window, the list is sorted by the
+// new scores. If a move is better than the window, the search stops
+// there and the move goes to the front of the list, so that it is
+// searched first next time. If every move is worse, the list is
+// left as it was.
+//
+// Returns the score of the best move, for the player at the root.
+// If the search is stopped, the return value is meaningless.
+static int search_root_window(Search_thread *thread, int alpha, int beta)
+{
+    char is_max = thread->is_max;
+    int window_alpha = alpha;
+    int best_score = -HUGE_NUMBER;
+    Scored_move new_moves[NUM_SQUARES];
+
+    start_from_root(thread);
+    for (int i = 0; i < thread->num_moves; i++)
+    {
+        int square = thread->root_moves[i].square;
+
+        make_move(thread, square);
+        int move_score = search_child(thread, 1, alpha, beta, is_max, i == 0);
+        unmake_move(thread);
+
+        if (stop_search)
+            return 0;
+
+        new_moves[i].square = square;
+        new_moves[i].score = move_score;
+        best_score = max(best_score, move_score);
+        alpha = max(alpha, move_score);
+
+        if (move_score >= beta)
         {
-            for (int j = 0; j < BOARD_SIZE; j++)
-            {
-                if ((*game).board[i][j].status == valid)
-                {
-                    // Save the move.
-                    aux_move.column = j;
-                    aux_move.row = i;
-
-                    // Make the move and transform the board.
-                    transform_board(game, aux_move);
-
-                    // If there are valid moves, switch the player.
-                    if (check_for_valid_moves(game))
-                    {
-                        // Switch the player.
-                        switch_player(&game->turn);
-                        is_max = !is_max;
-                    }
-
-                    // If there aren't valid moves, the next player
-                    // has to pass its turn.
-                    else
-                    {
-                        // Mark all squares where the next move could be made.
-                        mark_valid_moves(game, get_players_color(*game));
-                    }
-
-                    // Calculate the score for this move.
-                    int move_score =
-                        minimax(game, 0, is_max, -HUGE_NUMBER, HUGE_NUMBER);
-
-                    // If this move produces a better (higher) score
-                    // than the current best score, this is the new
-                    // best move.
-                    if (best_score < move_score)
-                    {
-                        (*move).row = i;
-                        (*move).column = j;
-                        best_score = move_score;
-                    }
-
-                    // Undo the move.
-                    (*game) = game_copy;
-                }
-            }
+            for (int j = i; j > 0; j--)
+                thread->root_moves[j] = thread->root_moves[j - 1];
+            thread->root_moves[0] = new_moves[i];
+            return best_score;
         }
     }
 
-    // Return the best possible score.
+    if (best_score <= window_alpha)
+        return best_score;
+
+    // The iteration is complete. Sort the moves for the next one.
+    for (int i = 0; i < thread->num_moves; i++)
+        thread->root_moves[i] = new_moves[i];
+    sort_root_moves(thread->root_moves, thread->num_moves);
+
+    // Only the score of the best move is exact.
+    store_transposition_table(
+            &table, thread->hash, thread->search_depth, best_score, exact,
+            thread->root_moves[0].square);
+
     return best_score;
 }
 
 
-// Evaluation function. Black is the minimizer and white is the
-// maximizer.
-static int evaluate(Game *game)
+// Version of search_root() for the iteration that reaches the end
+// of the game, which is solved exactly by the endgame solver (see
+// endgame.c).
+static int solve_root(Search_thread *thread)
 {
-    // If there are no move valid moves, check who won.
-    //
-    // The minimax() and find_best_move() function take care of
-    // passing a turn when appropiate. If here we don't have
-    // valid moves, it means that the game is over.
-    if (!check_for_valid_moves(game))
+    Endgame_search search =
     {
-        int black_count = 0;
-        int white_count = 0;
+        &table, 0, 0, 0, 0, 0,
+        thread->id == 0 ? check_clock : is_search_stopped, FALSE
+    };
+    char is_max = thread->is_max;
+    int best_difference = ENDGAME_MIN_SCORE;
+    Scored_move new_moves[NUM_SQUARES];
+
+    start_from_root(thread);
+    for (int i = 0; i < thread->num_moves; i++)
+    {
+        int square = thread->root_moves[i].square;
+        int difference;
+
+        make_move(thread, square);
+        const Position *child = &thread->position;
+        char same_player = thread->position_is_max == is_max;
+
+        // Only moves better than the best one so far matter. The
+        // first move is solved exactly, and the other ones are only
+        // tested against it (which is much faster) unless they turn
+        // out to be better.
+        if (i == 0)
+            difference = solve_move(
+                    &search, child, same_player,
+                    ENDGAME_MIN_SCORE, ENDGAME_MAX_SCORE);
+        else
+        {
+            difference = solve_move(
+                    &search, child, same_player,
+                    best_difference, best_difference + 1);
+            if (difference > best_difference)
+                difference = solve_move(
+                        &search, child, same_player,
+                        best_difference, ENDGAME_MAX_SCORE);
+        }
+        unmake_move(thread);
 
-        // Count the amount of black and white discs.
-        get_game_score(game, 0, 0, &white_count, &black_count);
+        if (search.stopped || stop_search)
+            break;
 
-        // Minimizer (black) has won.
-        if (black_count > white_count)
-            return MIN_SCORE;
+        new_moves[i].square = square;
+        new_moves[i].score = difference;
+        if (i == 0 || difference > best_difference)
+            best_difference = difference;
+    }
 
-        // Maximizer (white) has won.
-        else if (black_count < white_count)
-            return MAX_SCORE;
+    Search_counters *counters = &thread->counters;
+    counters->nodes += search.nodes;
+    counters->table_probes += search.table_probes;
+    counters->table_hits += search.table_hits;
+    counters->cutoffs += search.cutoffs;
+    counters->first_move_cutoffs += search.first_move_cutoffs;
+    if (search.stopped || stop_search)
+        return 0;
+
+    // The solver went to the end of the game.
+    counters->max_ply = max(counters->max_ply, thread->num_empties);
+
+    // Sort the moves from best to worst for the player.
+    for (int i = 0; i < thread->num_moves; i++)
+        thread->root_moves[i] = new_moves[i];
+    sort_root_moves(thread->root_moves, thread->num_moves);
+
+    // The table keeps the score for the player.
+    store_transposition_table(
+            &table, thread->hash, thread->search_depth,
+            solved_score(best_difference, TRUE), exact,
+            thread->root_moves[0].square);
+
+    return solved_score(best_difference, is_max);
+}
 
-        // Draw.
-        else
-            return 0;
+
+// Solves the position after a root move, for the window given
+// from the point of view of the player at the root.
+//
+// The solver gives the final disc difference for the side to move
+// after the move, which is the same player if the opponent has to
+// pass.
+static int solve_move(
+        Endgame_search *search, const Position *child, char same_player,
+        int alpha, int beta)
+{
+    if (same_player)
+        return solve_endgame(search, child, alpha, beta);
+    return -solve_endgame(search, child, -beta, -alpha);
+}
+
+
+// Converts the final disc difference of a solved game, for the
+// side to move, to a minimax score (a won game scores beyond the
+// winner's limit by the difference).
+static int solved_score(int difference, char is_max)
+{
+    int white_difference = is_max ? difference : -difference;
+
+    if (white_difference > 0)
+        return MAX_SCORE + white_difference;
+    else if (white_difference < 0)
+        return MIN_SCORE + white_difference;
+    else
+        return 0;
+}
+
+
+// Sorts the root moves from the highest to the lowest score (from
+// best to worst for the player). The sort is stable, so moves with
+// the same score keep their order.
+static void sort_root_moves(Scored_move root_moves[], int num_moves)
+{
+    for (int i = 1; i < num_moves; i++)
+    {
+        Scored_move root_move = root_moves[i];
+        int j = i - 1;
+
+        while (j >= 0 && root_moves[j].score < root_move.score)
+        {
+            root_moves[j + 1] = root_moves[j];
+            j--;
+        }
+        root_moves[j + 1] = root_move;
     }
+}
 
-    // If there are valid moves, the game isn't over.
-    return 0;
+
+// Evaluation function for a finished game. Black is the
+// minimizer and white is the maximizer.
+//
+// Finished games score like solved ones (see solved_score()): the
+// widest wins are preferred. The score doesn't depend on the ply
+// where the game ends, so a position stored in the transposition
+// table scores the same wherever it is found again.
+static int evaluate(const Position *position, char is_max)
+{
+    int difference =
+        count_discs(position->player) - count_discs(position->opponent);
+
+    return solved_score(difference, is_max);
 }
 
 
-static int minimax(
-        Game *game, int depth, char is_max, int alpha, int beta)
+// Searches the position after a move with principal variation
+// search. Only the first move of a node gets the whole window: the
+// other ones are first searched with a null window, which only
+// tells whether they are better than alpha, and the few that are
+// get searched again.
+//
+// Arguments:
+// The thread, after making the move.
+// The ply of the position after the move.
+// The window, from the point of view of the player who moved.
+// The player who moved (which is also the side to move if the
+// opponent has to pass).
+// Whether it's the first move of the node.
+//
+// Returns the score of the move for the player who made it.
+static int search_child(
+        Search_thread *thread, int depth, int alpha, int beta, char is_max,
+        char first_move)
 {
-    // Boolean value to know if the child of this move
-    // will be pruned.
-    int prune = FALSE;
+    char same_player = thread->position_is_max == is_max;
 
-    // Auxiliary variable to store the tentative moves on
-    // each node.
-    Move aux_move;
+    if (!first_move)
+    {
+        int score = same_player ?
+            negamax(thread, depth, alpha, alpha + 1) :
+            -negamax(thread, depth, -alpha - 1, -alpha);
 
-    // Variable for storing the score of the best possible
-    // move on this level.
-    int best_score;
+        if (score <= alpha || score >= beta)
+            return score;
+    }
+
+    if (same_player)
+        return negamax(thread, depth, alpha, beta);
+    return -negamax(thread, depth, -beta, -alpha);
+}
 
-    // Calculate the score for the current board configuration.
-    int score = evaluate(game);
+
+// Searches the position of the thread (see make_move()).
+//
+// Arguments:
+// The thread.
+// The ply of the position, counted from the root of the search.
+// The window of the search, for the side to move.
+//
+// Returns the score of the position for the side to move (the
+// minimax score if the side to move is white, and its opposite
+// otherwise).
+static int negamax(Search_thread *thread, int depth, int alpha, int beta)
+{
+    // The position of the thread is the same again after every
+    // child has been taken back.
+    const Position *position = &thread->position;
+    uint64_t hash = thread->position_hash;
+    char is_max = thread->position_is_max;
+    int sign = is_max ? 1 : -1;
+
+    // Best score and move found so far.
+    int best_score = -HUGE_NUMBER;
+    int best_move = NO_MOVE;
+
+    int search_depth = thread->search_depth;
+
+    // Best move found the last time this position was searched.
+    int table_move = NO_MOVE;
+    Transposition_entry entry;
+
+    // The main thread checks the clock every now and then, and
+    // gives up on the iteration if the time is over. The first
+    // iteration is always completed, so that there is a move to
+    // play.
+    Search_counters *counters = &thread->counters;
+    if (
+            ++counters->nodes % NODES_PER_CLOCK_CHECK == 0 &&
+            thread->id == 0 && search_depth > 1 &&
+            get_time() >= deadline)
+        stop_search = TRUE;
+    if (stop_search)
+        return 0;
+    counters->max_ply = max(counters->max_ply, thread->ply);
+
+    Bitboard moves = get_valid_moves(position);
 
     // Base cases.
     //
-    // The minimizing player won.
-    if (score == MIN_SCORE)
-        return score + depth + evaluate_corners(game);
-
-    // The maximizing player won.
-    else if (score == MAX_SCORE)
-        return score - depth + evaluate_corners(game);
+    // make_move() takes care of passing a turn when
+    // appropiate. If here we don't have valid moves, it means
+    // that the game is over.
+    if (!moves)
+    {
+        counters->evaluations++;
+        return sign * evaluate(position, is_max);
+    }
 
     // Maximum depth has been reached and nobody won.
-    else if (depth == MAX_DEPTH)
-        return score + evaluate_corners(game);
-
-    // Save the state of the game before trying a move.
-    Game game_copy = (*game);
+    else if (depth == search_depth)
+    {
+        counters->evaluations++;
+        return sign * evaluate_heuristic(thread);
+    }
 
-    // Recursive case. Try every valid move possible.
-    // Minimizer's turn (black discs).
-    if (!is_max)
+    // If this position was already searched at least as deep,
+    // use the stored score to narrow the window (or return it
+    // right away if it's exact or causes a cutoff).
+    counters->table_probes++;
+    if (probe_transposition_table(&table, hash, &entry))
     {
-        best_score = HUGE_NUMBER;
-        for (int i = 0; i < BOARD_SIZE; i++)
+        counters->table_hits++;
+        table_move = entry.best_move;
+        if (entry.depth >= search_depth - depth)
         {
-            // If the child of this node will be pruned,
-            // get out of the loop.
-            if (prune)
-                break;
-
-            // Else continue with the evaluation.
-            for (int j = 0; j < BOARD_SIZE; j++)
-            {
-                if ((*game).board[i][j].status == valid)
-                {
-                    // Save the move.
-                    aux_move.column = j;
-                    aux_move.row = i;
-
-                    // Make the move and transform the board.
-                    transform_board(game, aux_move);
-
-                    // If there are valid moves, switch the player.
-                    if (check_for_valid_moves(game))
-                    {
-                        switch_player(&game->turn);
-                        is_max = !is_max;
-                    }
-
-                    // If there aren't valid moves, the next player
-                    // has to pass its turn and we don't switch players.
-                    else
-                    {
-                        // Mark all squares where the next move could be made.
-                        mark_valid_moves(game, get_players_color(*game));
-                    }
-
-                    // Calculate the score for this move.
-                    int move_score =
-                        minimax(game, depth+1, is_max, alpha, beta);
-
-                    // If this move produces a better (lower) score
-                    // than the current best score, this is the new
-                    // best move.
-                    best_score = min(best_score, move_score);
-                    beta = min(beta, move_score);
-                    if (beta <= alpha)
-                        prune = TRUE;
-
-                    // Undo the move.
-                    (*game) = game_copy;
-                }
-            }
+            if (entry.bound == exact)
+                return entry.score;
+            else if (entry.bound == lower_bound)
+                alpha = max(alpha, entry.score);
+            else
+                beta = min(beta, entry.score);
+
+            if (beta <= alpha)
+                return entry.score;
         }
     }
 
-    // Maximizer's turn (white discs).
-    else
+    // Only the null windows of the moves that aren't the first one
+    // (see search_child()) are pruned, so that the scores of the
+    // principal variation are always searched in full.
+    int probcut_score;
+    if (
+            probcut && !thread->in_probcut && beta == alpha + 1 &&
+            try_probcut(thread, depth, beta, &probcut_score))
+    {
+        counters->probcuts++;
+        return probcut_score;
+    }
+
+    // Lower end of the window, used to tell what kind of bound the
+    // best score is.
+    int window_alpha = alpha;
+
+    // Recursive case. Try every valid move possible, best-first.
+    Scored_move move_list[NUM_SQUARES];
+    int num_moves = score_moves(
+            &thread->ordering, moves, table_move, depth, is_max, move_list);
+
+    for (int i = 0; i < num_moves; i++)
     {
-        best_score = -HUGE_NUMBER;
-        for (int i = 0; i < BOARD_SIZE; i++)
+        int square = select_next_move(move_list, num_moves, i);
+
+        // Calculate the score for this move.
+        make_move(thread, square);
+        int move_score =
+            search_child(thread, depth + 1, alpha, beta, is_max, i == 0);
+        unmake_move(thread);
+
+        // The time is over. This node's result is incomplete, so
+        // it must not be stored.
+        if (stop_search)
+            return 0;
+
+        if (move_score > best_score)
+        {
+            best_score = move_score;
+            best_move = square;
+        }
+        alpha = max(alpha, move_score);
+
+        // The rest of the children of this node will be pruned.
+        // Remember the move that caused it.
+        if (alpha >= beta)
         {
-            // If the child of this node will be pruned,
-            // get out of the loop.
-            if (prune)
-                break;
-
-            // Else continue with the evaluation.
-            for (int j = 0; j < BOARD_SIZE; j++)
-            {
-                if ((*game).board[i][j].status == valid)
-                {
-                    // Save the move.
-                    aux_move.column = j;
-                    aux_move.row = i;
-
-                    // Make the move and transform the board.
-                    transform_board(game, aux_move);
-
-                    // If there are valid moves, switch the player.
-                    if (check_for_valid_moves(game))
-                    {
-                        switch_player(&game->turn);
-                        is_max = !is_max;
-                    }
-
-                    // If there aren't valid moves, the next player
-                    // has to pass its turn and we don't switch players.
-                    else
-                    {
-                        // Mark all squares where the next move could be made.
-                        mark_valid_moves(game, get_players_color(*game));
-                    }
-
-                    // Calculate the score for this move.
-                    int move_score =
-                        minimax(game, depth+1, is_max, alpha, beta);
-
-                    // If this move produces a better (higher) score
-                    // than the current best score, this is the new
-                    // best move.
-                    best_score = max(best_score, move_score);
-                    alpha = max(alpha, move_score);
-                    if (beta <= alpha)
-                        prune = TRUE;
-
-                    // Undo the move.
-                    (*game) = game_copy;
-                }
-            }
+            record_cutoff(
+                    &thread->ordering, square, depth, search_depth - depth,
+                    is_max);
+            counters->cutoffs++;
+            counters->first_move_cutoffs += i == 0;
+            break;
         }
     }
 
-    // Return the best score. Because in minimax we assume that
-    // each player is playing perfectly.
+    // Save the result for the next time this position is reached.
+    bound bound = exact;
+    if (best_score <= window_alpha)
+        bound = upper_bound;
+    else if (best_score >= beta)
+        bound = lower_bound;
+    store_transposition_table(
+            &table, hash, search_depth - depth, best_score, bound,
+            best_move);
+
     return best_score;
 }
 
 
+// Tries to prune the position of the thread with ProbCut: a
+// shallow search predicts the score of the deep one, and if the
+// prediction is outside the null window by enough, the deep search
+// is skipped.
+//
+// The shallow search is a search of the same thread, with the
+// horizon brought closer.
+//
+// Arguments:
+// The thread.
+// The ply of the position, counted from the root of the search.
+// The upper end of the null window, for the side to move.
+// Where to put the score of the position if it is pruned.
+//
+// Returns whether the position was pruned.
+static char try_probcut(
+        Search_thread *thread, int depth, int beta, int *score)
+{
+    const Position *position = &thread->position;
+    int empties = count_discs(~(position->player | position->opponent));
+    int search_depth = thread->search_depth;
+    const Probcut_pair *pair =
+        get_probcut_pair(probcut, search_depth - depth, empties);
+    int alpha = beta - 1;
+
+    // The scores of won games can't be predicted.
+    if (!pair || alpha < -MAX_EVALUATION || beta > MAX_EVALUATION)
+        return FALSE;
+
+    // Shallow scores that put the deep score beyond the window with
+    // the confidence of the threshold.
+    double margin = PROBCUT_THRESHOLD * pair->sigma;
+    int high_bound =
+        (int) ceil((beta + margin - pair->intercept) / pair->slope);
+    int low_bound =
+        (int) floor((alpha - margin - pair->intercept) / pair->slope);
+    char pruned = FALSE;
+
+    thread->search_depth = depth + pair->shallow_depth;
+    thread->in_probcut = TRUE;
+    if (
+            high_bound <= MAX_EVALUATION &&
+            negamax(thread, depth, high_bound - 1, high_bound) >=
+            high_bound)
+    {
+        *score = beta;
+        pruned = TRUE;
+    }
+    else if (
+            low_bound >= -MAX_EVALUATION &&
+            negamax(thread, depth, low_bound, low_bound + 1) <= low_bound)
+    {
+        *score = alpha;
+        pruned = TRUE;
+    }
+    thread->search_depth = search_depth;
+    thread->in_probcut = FALSE;
+
+    return pruned && !stop_search;
+}
+
+
+// Sets the position of the thread to the root of the search.
+static void start_from_root(Search_thread *thread)
+{
+    thread->position = thread->root;
+    thread->position_hash = thread->hash;
+    thread->position_is_max = thread->is_max;
+    thread->ply = 0;
+
+    // The indices of the patterns and the accumulators of the
+    // network are updated move by move from here on.
+    const Position *root = &thread->root;
+    Bitboard black = thread->is_max ? root->opponent : root->player;
+    Bitboard white = thread->is_max ? root->player : root->opponent;
+
+    if (network)
+        refresh_accumulator(network, black, white, &thread->accumulators[0]);
+    else if (pattern_tables)
+        compute_pattern_indices(black, white, &thread->pattern_indices);
+}
+
+
+// Plays a move on the position of the thread and hands the turn
+// over to the next player, pushing what changed on the undo stack.
+//
+// If the next player doesn't have any valid moves, its turn is
+// passed and the same player moves again.
+//
+// The Zobrist key and the side to move are updated along with the
+// position.
+static void make_move(Search_thread *thread, int square)
+{
+    Nnue_accumulator *accumulator = &thread->accumulators[thread->ply];
+    Undo_record *record = &thread->undo_stack[thread->ply++];
+    char is_max = thread->position_is_max;
+
+    record->square = square;
+    record->hash = thread->position_hash;
+    record->is_max = is_max;
+    record->flipped = play_move(&thread->position, square);
+    thread->position_hash = hash_move(
+            thread->position_hash, square, record->flipped, is_max);
+    if (network)
+        update_accumulator(
+                network, accumulator, accumulator + 1, square,
+                record->flipped, is_max);
+    else if (pattern_tables)
+        update_pattern_indices(
+                &thread->pattern_indices, square, record->flipped, is_max);
+
+    // If there are valid moves, switch the player.
+    if (get_valid_moves(&thread->position))
+    {
+        thread->position_hash = hash_switch_player(thread->position_hash);
+        thread->position_is_max = !is_max;
+        record->passed = FALSE;
+    }
+
+    // If there aren't valid moves, the next player has to
+    // pass its turn and we don't switch players.
+    else
+    {
+        pass_turn(&thread->position);
+        record->passed = TRUE;
+    }
+
+    // The new position is probed soon.
+    prefetch_transposition_table(&table, thread->position_hash);
+}
+
+
+// Takes back the last move made with make_move().
+static void unmake_move(Search_thread *thread)
+{
+    const Undo_record *record = &thread->undo_stack[--thread->ply];
+
+    if (record->passed)
+        pass_turn(&thread->position);
+    undo_move(&thread->position, record->square, record->flipped);
+    if (!network && pattern_tables)
+        restore_pattern_indices(
+                &thread->pattern_indices, record->square, record->flipped,
+                record->is_max);
+    thread->position_hash = record->hash;
+    thread->position_is_max = record->is_max;
+}
+
+
+// Stops the search if its time is over. Called by the main
+// thread while solving the endgame.
+//
+// Returns whether the search has stopped.
+static char check_clock(void)
+{
+    if (get_time() >= deadline)
+        stop_search = TRUE;
+    return stop_search;
+}
+
+
+// Returns whether the search has stopped. Called by the helper
+// threads while solving the endgame.
+static char is_search_stopped(void)
+{
+    return stop_search;
+}
+
+
+// Adds the counters of a thread to the total ones.
+static void add_counters(
+        Search_counters *total, const Search_counters *counters)
+{
+    total->nodes += counters->nodes;
+    total->evaluations += counters->evaluations;
+    total->cutoffs += counters->cutoffs;
+    total->first_move_cutoffs += counters->first_move_cutoffs;
+    total->probcuts += counters->probcuts;
+    total->table_probes += counters->table_probes;
+    total->table_hits += counters->table_hits;
+    total->max_ply = max(total->max_ply, counters->max_ply);
+}
+
+
+// Returns the time elapsed since an arbitrary point, in seconds.
+static double get_time(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+
 // Get the minimum value between two integers.
 static int min(int a, int b)
 {
@@ -380,29 +1217,30 @@ static int max(int a, int b)
 }
 
 
-// Returns a score associated with controlling the
-// corners of the board.
-static int evaluate_corners(Game *game)
+// Returns the heuristic score of the position of a thread that
+// isn't finished, from the point of view of white (the maximizer).
+//
+// The score comes from the network if there is one, then from the
+// pattern tables, and otherwise from the weights of the features.
+static int evaluate_heuristic(const Search_thread *thread)
 {
-    int score = 0;
-
-    // Indices of the corners of the board.
-    int indices[2] = { 0, BOARD_SIZE-1 };
-
-    // Iterate through the indices of the corners.
-    for (int i = 0; i < 2; i++)
+    const Position *position = &thread->position;
+    int score;
+
+    // The network and the tables score the position for black, and
+    // the features for the side to move.
+    int empties = count_discs(~(position->player | position->opponent));
+    if (network)
+        score = -evaluate_network(
+                network, &thread->accumulators[thread->ply], empties);
+    else if (pattern_tables)
+        score = -evaluate_patterns(
+                pattern_tables, &thread->pattern_indices, empties);
+    else
     {
-        for (int j = 0; j < 2; j++)
-        {
-            if ((*game).board[indices[i]][indices[j]].status == full)
-            {
-                if ((*game).board[indices[i]][indices[j]].color == black)
-                    score -= CORNER_VALUE;
-                else
-                    score += CORNER_VALUE;
-            }
-        }
+        score = evaluate_position(position, &weights);
+        if (!thread->position_is_max)
+            score = -score;
     }
-    // Return the score.
-    return score;
+    return min(max(score, -MAX_EVALUATION), MAX_EVALUATION);
 }
@@ -1,8 +1,127 @@
 #ifndef _MINIMAX_
 #define _MINIMAX_
 
-#include "../game.h"
+#include "../bitboard/bitboard.h"
+#include "evaluation.h"
+#include "probcut.h"
+#include "../patterns/patterns.h"
+#include "../nnue/nnue.h"
 
-int find_best_move(Game *game, Move *move);
+// Default time budget for every move, in seconds.
+#define DEFAULT_MOVE_TIME 1.0
+
+// Maximum number of threads of the search.
+#define MAX_THREADS 64
+
+// Engines that can search the positions: alpha-beta (minimax) and
+// Monte Carlo Tree Search.
+#define ENGINE_ALPHA_BETA 0
+#define ENGINE_MCTS 1
+
+// Settings of the search engine, chosen at startup.
+typedef struct Search_options
+{
+    // Size of the transposition table, in megabytes.
+    int hash_size;
+
+    // Time budget for every move, in seconds.
+    double move_time;
+
+    // Maximum depth of the search, in plies (0 for no limit but
+    // the time).
+    int max_depth;
+
+    // Number of threads of the search.
+    int threads;
+
+    // Number of empty squares from which the game is solved to
+    // the end (0 to never solve it before the last move).
+    int endgame_empties;
+
+    // Path of the opening book, or NULL to play without one.
+    const char *book_path;
+
+    // Whether to search while the opponent thinks.
+    char ponder;
+
+    // Weights of the evaluation, or NULL for the default ones.
+    const Evaluation_weights *weights;
+
+    // Pattern tables that replace the weights in the evaluation,
+    // or NULL to evaluate with the weights.
+    const Pattern_tables *patterns;
+
+    // Network that replaces the weights and the pattern tables in
+    // the evaluation, or NULL to evaluate without one.
+    const Nnue_network *network;
+
+    // Engine that searches the positions before the endgame (the
+    // endgame is always solved with alpha-beta), and maximum number
+    // of playouts of the MCTS engine (0 for no limit but the time).
+    // The MCTS tree takes as much memory as the transposition
+    // table.
+    char engine;
+    long max_playouts;
+
+    // Calibration of ProbCut, which prunes the subtrees that a
+    // shallow search says are almost surely outside the window, or
+    // NULL to search without it.
+    const Probcut_parameters *probcut;
+} Search_options;
+
+// Statistics of a search, added up over all the threads.
+typedef struct Search_counters
+{
+    // Nodes visited, and leaves of the search that were evaluated
+    // (the endgame solver doesn't evaluate positions).
+    unsigned long nodes;
+    unsigned long evaluations;
+
+    // Nodes where a move caused a cutoff, and how many of them the
+    // first move tried caused (the more, the better the moves are
+    // sorted).
+    unsigned long cutoffs;
+    unsigned long first_move_cutoffs;
+
+    // Nodes that ProbCut pruned.
+    unsigned long probcuts;
+
+    // Probes of the transposition table, and how many found the
+    // position.
+    unsigned long table_probes;
+    unsigned long table_hits;
+
+    // Farthest ply from the root that was reached.
+    int max_ply;
+
+    // Time spent, in seconds.
+    double elapsed;
+} Search_counters;
+
+// Result of searching a position.
+typedef struct Search_result
+{
+    // Best move found and its minimax score.
+    int square;
+    int score;
+
+    // Depth of the last iteration that was completed.
+    int depth;
+
+    // What the search did to find the move.
+    Search_counters counters;
+} Search_result;
+
+int init_search(const Search_options *options);
+void set_search_options(const Search_options *options);
+void set_search_threads(int count);
+void clear_search(void);
+int search_position(
+        const Position *position, char is_max, Search_result *result);
+int probe_opening_book(const Position *position, int *square);
+double get_first_move_cutoff_rate(const Search_counters *counters);
+double get_table_hit_rate(const Search_counters *counters);
+void start_pondering(const Position *position, char is_max);
+void stop_pondering(void);
 
 #endif
@@ -0,0 +1,152 @@
+#include <string.h>
+#include "move_ordering.h"
+#include "transposition.h"
+
+// Sort scores of the move stored in the transposition table and
+// of the two killer moves. They are higher than any score given
+// by the history and the square priorities.
+#define TABLE_MOVE_SCORE (1 << 30)
+#define FIRST_KILLER_SCORE (1 << 29)
+#define SECOND_KILLER_SCORE (1 << 28)
+
+// When a history score goes over this limit, all of them are
+// halved, so that they stay below the killer scores.
+#define HISTORY_LIMIT (1 << 24)
+
+// Static priority of each square. Corners are the best moves,
+// and the squares next to them (X-squares on the diagonal and
+// C-squares on the edges) the worst, because they give corners
+// away.
+static const int square_priority[NUM_SQUARES] =
+{
+    1000, -200, 100,  50,  50, 100, -200, 1000,
+    -200, -500, -20, -20, -20, -20, -500, -200,
+     100,  -20,  10,  10,  10,  10,  -20,  100,
+      50,  -20,  10,   0,   0,  10,  -20,   50,
+      50,  -20,  10,   0,   0,  10,  -20,   50,
+     100,  -20,  10,  10,  10,  10,  -20,  100,
+    -200, -500, -20, -20, -20, -20, -500, -200,
+    1000, -200, 100,  50,  50, 100, -200, 1000
+};
+
+static void halve_history(Move_ordering *ordering);
+
+
+// Forgets everything learned about good moves.
+void clear_move_ordering(Move_ordering *ordering)
+{
+    memset(ordering, 0, sizeof(Move_ordering));
+    for (int ply = 0; ply < MAX_PLY; ply++)
+    {
+        ordering->killers[ply][0] = NO_MOVE;
+        ordering->killers[ply][1] = NO_MOVE;
+    }
+}
+
+
+// Prepares the move ordering for the search of a new move. The
+// killer moves were found at plies counted from the previous root,
+// so they are cleared, and the history loses half of its weight.
+void age_move_ordering(Move_ordering *ordering)
+{
+    for (int ply = 0; ply < MAX_PLY; ply++)
+    {
+        ordering->killers[ply][0] = NO_MOVE;
+        ordering->killers[ply][1] = NO_MOVE;
+    }
+    halve_history(ordering);
+}
+
+
+// Builds the list of moves of a node, with a sort score for each.
+//
+// Arguments:
+// The move ordering data of the search.
+// The set of valid moves.
+// The best move stored in the transposition table (or NO_MOVE).
+// The ply of the node, counted from the root of the search.
+// Whether the side to move is the maximizer (white).
+// An array to store the list (with room for every square).
+//
+// Returns the number of moves in the list.
+int score_moves(
+        const Move_ordering *ordering, Bitboard moves, int table_move,
+        int ply, char is_max, Scored_move move_list[])
+{
+    int num_moves = 0;
+    const int *history = ordering->history[is_max ? 0 : 1];
+
+    while (moves)
+    {
+        int square = pop_first_square(&moves);
+        int score;
+
+        if (square == table_move)
+            score = TABLE_MOVE_SCORE;
+        else if (square == ordering->killers[ply][0])
+            score = FIRST_KILLER_SCORE;
+        else if (square == ordering->killers[ply][1])
+            score = SECOND_KILLER_SCORE;
+        else
+            score = history[square] + square_priority[square];
+
+        move_list[num_moves].square = square;
+        move_list[num_moves].score = score;
+        num_moves++;
+    }
+    return num_moves;
+}
+
+
+// Moves the best of the moves not tried yet (from the given index
+// on) to the given index, and returns its square.
+//
+// Sorting the list one move at a time saves work when the search
+// of the node is cut off after the first few moves.
+int select_next_move(Scored_move move_list[], int num_moves, int index)
+{
+    int best = index;
+
+    for (int i = index + 1; i < num_moves; i++)
+    {
+        if (move_list[i].score > move_list[best].score)
+            best = i;
+    }
+
+    Scored_move best_move = move_list[best];
+    move_list[best] = move_list[index];
+    move_list[index] = best_move;
+    return best_move.square;
+}
+
+
+// Remembers a move that caused a cutoff: it becomes the first
+// killer move of its ply, and its history score grows with the
+// depth that was left to search below the node.
+void record_cutoff(
+        Move_ordering *ordering, int square, int ply, int depth_left,
+        char is_max)
+{
+    int *killers = ordering->killers[ply];
+    int *history = ordering->history[is_max ? 0 : 1];
+
+    if (killers[0] != square)
+    {
+        killers[1] = killers[0];
+        killers[0] = square;
+    }
+
+    history[square] += depth_left * depth_left;
+    if (history[square] > HISTORY_LIMIT)
+        halve_history(ordering);
+}
+
+
+static void halve_history(Move_ordering *ordering)
+{
+    for (int side = 0; side < 2; side++)
+    {
+        for (int square = 0; square < NUM_SQUARES; square++)
+            ordering->history[side][square] /= 2;
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef _MOVE_ORDERING_
+#define _MOVE_ORDERING_
+
+#include "../bitboard/bitboard.h"
+
+// Maximum number of plies from the root of a search.
+#define MAX_PLY 64
+
+// A move together with the score used to sort it.
+typedef struct Scored_move
+{
+    int square;
+    int score;
+} Scored_move;
+
+// What the search has learned about good moves: two killer moves
+// (moves that caused a cutoff) for every ply, and the history of
+// cutoffs caused by every square, for each color (white is 0 and
+// black is 1).
+typedef struct Move_ordering
+{
+    int killers[MAX_PLY][2];
+    int history[2][NUM_SQUARES];
+} Move_ordering;
+
+void clear_move_ordering(Move_ordering *ordering);
+void age_move_ordering(Move_ordering *ordering);
+int score_moves(
+        const Move_ordering *ordering, Bitboard moves, int table_move,
+        int ply, char is_max, Scored_move move_list[]);
+int select_next_move(Scored_move move_list[], int num_moves, int index);
+void record_cutoff(
+        Move_ordering *ordering, int square, int ply, int depth_left,
+        char is_max);
+
+#endif
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <string.h>
+#include "probcut.h"
+
+// Maximum length of a line of a calibration file.
+#define MAX_LINE_LENGTH 256
+
+
+// Returns the depth of the shallow search that predicts a search of
+// the given depth: about half of it, with the same parity (the
+// scores of odd and even depths aren't alike in Othello).
+int get_probcut_depth(int depth)
+{
+    return depth / 4 * 2 + depth % 2;
+}
+
+
+// Reads a calibration of ProbCut from a file (see
+// probcut_calibrator.c). Every line has the phase, the depth of the
+// deep search, the depth of the shallow search, the slope, the
+// intercept and the standard deviation. Empty lines and lines
+// starting with '#' are skipped. The depths that the file leaves
+// out are never pruned.
+//
+// Returns 1 on success and 0 if the file couldn't be read or has a
+// line that doesn't make sense (the parameters are left untouched
+// then).
+int load_probcut_parameters(const char *path, Probcut_parameters *parameters)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return 0;
+
+    Probcut_parameters read_parameters;
+    char line[MAX_LINE_LENGTH];
+
+    memset(&read_parameters, 0, sizeof(Probcut_parameters));
+    while (fgets(line, sizeof(line), file))
+    {
+        // Skip the blanks at the start of the line.
+        const char *start = line;
+        while (*start == ' ' || *start == '\t')
+            start++;
+        if (*start == '#' || *start == '\n' || *start == '\0')
+            continue;
+
+        int phase;
+        int depth;
+        Probcut_pair pair;
+        char extra;
+
+        if (
+                sscanf(
+                    start, "%d %d %d %lf %lf %lf %c", &phase, &depth,
+                    &pair.shallow_depth, &pair.slope, &pair.intercept,
+                    &pair.sigma, &extra) != 6 ||
+                phase < 0 || phase >= NUM_PHASES ||
+                depth < MIN_PROBCUT_DEPTH || depth > MAX_PROBCUT_DEPTH ||
+                pair.shallow_depth < 1 || pair.shallow_depth >= depth ||
+                pair.slope <= 0 || pair.sigma < 0)
+        {
+            fclose(file);
+            return 0;
+        }
+        read_parameters.pairs[phase][depth] = pair;
+    }
+    fclose(file);
+
+    *parameters = read_parameters;
+    return 1;
+}
+
+
+// Returns the calibration for a search of the given depth from a
+// position with the given number of empty squares, or NULL if the
+// search can't be predicted.
+const Probcut_pair *get_probcut_pair(
+        const Probcut_parameters *parameters, int depth, int empties)
+{
+    if (depth < MIN_PROBCUT_DEPTH || depth > MAX_PROBCUT_DEPTH)
+        return NULL;
+
+    const Probcut_pair *pair =
+        &parameters->pairs[get_game_phase(empties)][depth];
+    return pair->shallow_depth ? pair : NULL;
+}
@@ -0,0 +1,40 @@
+#ifndef _PROBCUT_
+#define _PROBCUT_
+
+#include "evaluation.h"
+
+// Range of the depths (plies left to search) where ProbCut can
+// prune.
+#define MIN_PROBCUT_DEPTH 3
+#define MAX_PROBCUT_DEPTH 20
+
+// How many standard deviations the shallow search must clear the
+// window by to prune. The higher, the fewer mistakes and the fewer
+// nodes pruned.
+#define PROBCUT_THRESHOLD 1.5
+
+// How a search of some depth predicts the score of a deeper one:
+// the deep score is about slope * shallow score + intercept, with
+// the given standard deviation. A shallow depth of 0 means that
+// there is nothing to predict with.
+typedef struct Probcut_pair
+{
+    int shallow_depth;
+    double slope;
+    double intercept;
+    double sigma;
+} Probcut_pair;
+
+// Calibration of ProbCut for every phase of the game and every
+// depth of the deep search.
+typedef struct Probcut_parameters
+{
+    Probcut_pair pairs[NUM_PHASES][MAX_PROBCUT_DEPTH + 1];
+} Probcut_parameters;
+
+int get_probcut_depth(int depth);
+int load_probcut_parameters(const char *path, Probcut_parameters *parameters);
+const Probcut_pair *get_probcut_pair(
+        const Probcut_parameters *parameters, int depth, int empties);
+
+#endif
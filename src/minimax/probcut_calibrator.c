@@ -0,0 +1,331 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include "../reversi.h"
+#include "../book/archive.h"
+
+// Default depth of the deepest searches, and number of positions
+// searched.
+#define DEFAULT_DEPTH 10
+#define DEFAULT_POSITIONS 1000
+
+// Fewest positions of a phase that a depth is calibrated with.
+#define MIN_SAMPLES 30
+
+// Scores beyond this are won games, which the calibration leaves
+// out.
+#define MAX_CALIBRATION_SCORE 5000
+
+// Positions collected from the games, and the depth of the deepest
+// searches.
+typedef struct Sample_list
+{
+    Position_list list;
+    int max_depth;
+} Sample_list;
+
+// Sums for the linear regression of the deep scores on the shallow
+// ones.
+typedef struct Regression
+{
+    double n;
+    double x;
+    double y;
+    double xx;
+    double xy;
+    double yy;
+} Regression;
+
+static int add_game(const Archive_game *game, void *samples);
+static int search_sample(
+        const Game_position *sample, Search_options *options, int max_depth,
+        int scores[]);
+static int write_calibration(
+        const char *path, Regression regressions[][MAX_PROBCUT_DEPTH + 1],
+        int max_depth, int num_searched, const char *evaluation);
+
+
+// Calibrates ProbCut for the evaluation of the engine.
+//
+// Positions from the games are searched at every depth up to the
+// given one, without ProbCut. For every phase of the game and every
+// depth, the scores are fitted to the scores of the shallow search
+// that predicts them (see get_probcut_depth()) with a linear
+// regression, whose slope, intercept and standard deviation are
+// written to the calibration file.
+//
+// The archives are the ones of the pattern trainer: a game on every
+// line, written as the moves played from the start (like
+// "F5D6C3D3C4..."). Empty lines and lines starting with '#' are
+// skipped (see read_archive()).
+//
+// Usage: probcut_calibrator [--depth=N] [--positions=N]
+//        [--weights=FILE | --patterns=FILE | --nnue=FILE]
+//        CALIBRATION ARCHIVE...
+int main(int argc, char **argv)
+{
+    static Evaluation_weights weights;
+    static Pattern_tables pattern_tables;
+    static Nnue_network network;
+    static Regression regressions[NUM_PHASES][MAX_PROBCUT_DEPTH + 1];
+    Sample_list samples = { { NULL, 0, 0 }, DEFAULT_DEPTH };
+    Position_list *list = &samples.list;
+    Search_options options =
+    {
+        DEFAULT_HASH_SIZE, DBL_MAX, 0, 1, 0, NULL, 0, NULL, NULL, NULL,
+        ENGINE_ALPHA_BETA, 0, NULL
+    };
+    int num_positions = DEFAULT_POSITIONS;
+    int num_searched = 0;
+    int first_file = 1;
+    int valid_options = 1;
+    char evaluation[MAX_LINE_LENGTH] =
+        "the default weights of the evaluation";
+
+    init_bitboard();
+    init_patterns();
+    while (
+            first_file < argc && valid_options &&
+            !strncmp(argv[first_file], "--", 2))
+    {
+        const char *argument = argv[first_file++];
+
+        if (sscanf(argument, "--depth=%d", &samples.max_depth) == 1)
+            continue;
+        else if (sscanf(argument, "--positions=%d", &num_positions) == 1)
+            continue;
+        else if (!strncmp(argument, "--weights=", strlen("--weights=")))
+        {
+            valid_options =
+                load_weights(argument + strlen("--weights="), &weights);
+            options.weights = &weights;
+            snprintf(
+                    evaluation, sizeof(evaluation), "the weights of %s",
+                    argument + strlen("--weights="));
+        }
+        else if (!strncmp(argument, "--patterns=", strlen("--patterns=")))
+        {
+            valid_options = load_pattern_tables(
+                    &pattern_tables, argument + strlen("--patterns="));
+            options.patterns = &pattern_tables;
+            snprintf(
+                    evaluation, sizeof(evaluation), "the pattern tables of %s",
+                    argument + strlen("--patterns="));
+        }
+        else if (!strncmp(argument, "--nnue=", strlen("--nnue=")))
+        {
+            valid_options =
+                load_network(&network, argument + strlen("--nnue="));
+            options.network = &network;
+            snprintf(
+                    evaluation, sizeof(evaluation), "the network of %s",
+                    argument + strlen("--nnue="));
+        }
+        else
+            valid_options = 0;
+    }
+    if (
+            !valid_options || argc - first_file < 2 ||
+            samples.max_depth <= MIN_PROBCUT_DEPTH ||
+            samples.max_depth > MAX_PROBCUT_DEPTH ||
+            num_positions <= 0)
+    {
+        fprintf(
+                stderr,
+                "Usage: %s [--depth=N] [--positions=N] "
+                "[--weights=FILE | --patterns=FILE | --nnue=FILE] "
+                "CALIBRATION ARCHIVE...\n",
+                argv[0]);
+        return 1;
+    }
+
+    // Read every game of every archive.
+    for (int i = first_file + 1; i < argc; i++)
+        if (read_archive(argv[i], add_game, &samples) < 0)
+            return 1;
+
+    if (!init_search(&options))
+    {
+        fprintf(stderr, "Could not allocate the transposition table.\n");
+        return 1;
+    }
+
+    // Search a random selection of the positions.
+    shuffle_game_positions(list->positions, list->num_positions);
+    if ((size_t) num_positions > list->num_positions)
+        num_positions = list->num_positions;
+    for (int i = 0; i < num_positions; i++)
+    {
+        const Game_position *sample = &list->positions[i];
+        int scores[MAX_PROBCUT_DEPTH + 1];
+
+        if (i > 0 && i % 100 == 0)
+            printf("%d positions searched.\n", i);
+        if (!search_sample(sample, &options, samples.max_depth, scores))
+            continue;
+        num_searched++;
+
+        int empties = count_discs(~(sample->black | sample->white));
+        Regression *phase_regressions =
+            regressions[get_game_phase(empties)];
+
+        for (
+                int depth = MIN_PROBCUT_DEPTH; depth <= samples.max_depth;
+                depth++)
+        {
+            Regression *regression = &phase_regressions[depth];
+            double x = scores[get_probcut_depth(depth)];
+            double y = scores[depth];
+
+            regression->n++;
+            regression->x += x;
+            regression->y += y;
+            regression->xx += x * x;
+            regression->xy += x * y;
+            regression->yy += y * y;
+        }
+    }
+
+    if (!write_calibration(
+                argv[first_file], regressions, samples.max_depth,
+                num_searched, evaluation))
+    {
+        fprintf(stderr, "Could not write %s.\n", argv[first_file]);
+        return 1;
+    }
+    printf("Calibration written to %s.\n", argv[first_file]);
+
+    free(list->positions);
+    return 0;
+}
+
+
+// Archive callback: adds to a Sample_list the positions of a game
+// where a search to the deepest depth doesn't reach the end of the
+// game and the side to move has a choice. The game doesn't need to
+// be complete.
+static int add_game(const Archive_game *game, void *samples)
+{
+    Sample_list *sample_list = samples;
+
+    for (int i = 0; i < game->num_plies; i++)
+    {
+        const Position *position = &game->positions[i];
+        int empties = count_discs(~(position->player | position->opponent));
+
+        if (
+                empties > sample_list->max_depth &&
+                count_discs(get_valid_moves(position)) > 1 &&
+                !add_game_position(
+                    &sample_list->list, position, game->white_to_move[i],
+                    game->black_score))
+            return -1;
+    }
+    return 1;
+}
+
+
+// Searches a position at every depth up to the given one, from
+// scratch, and puts the scores for the side to move in the array
+// (indexed by depth).
+//
+// Returns 1 on success and 0 if a search didn't complete its depth
+// or found a won game.
+static int search_sample(
+        const Game_position *sample, Search_options *options, int max_depth,
+        int scores[])
+{
+    Search_result result;
+    char is_max = sample->white_to_move;
+    Position position =
+    {
+        is_max ? sample->white : sample->black,
+        is_max ? sample->black : sample->white
+    };
+
+    clear_search();
+    for (int depth = 1; depth <= max_depth; depth++)
+    {
+        options->max_depth = depth;
+        set_search_options(options);
+
+        int score = search_position(&position, is_max, &result);
+        if (
+                result.depth != depth ||
+                score > MAX_CALIBRATION_SCORE ||
+                score < -MAX_CALIBRATION_SCORE)
+            return 0;
+        scores[depth] = is_max ? score : -score;
+    }
+    return 1;
+}
+
+
+// Fits the regressions and writes a line for every phase and depth
+// that had enough positions (see load_probcut_parameters()), after a
+// header that tells how the calibration was made.
+//
+// Arguments:
+// The path of the calibration file.
+// The sums of every phase and depth.
+// The depth of the deepest searches.
+// The number of positions that went into the sums.
+// The evaluation that was calibrated.
+//
+// Returns 1 on success and 0 on failure.
+static int write_calibration(
+        const char *path, Regression regressions[][MAX_PROBCUT_DEPTH + 1],
+        int max_depth, int num_searched, const char *evaluation)
+{
+    FILE *fp = fopen(path, "w");
+
+    if (!fp)
+        return 0;
+
+    fprintf(
+            fp,
+            "# Calibration of ProbCut for %s.\n"
+            "# Read it with --probcut=FILE (and with --a-probcut / "
+            "--b-probcut by\n"
+            "# the tournament runner). Written by probcut_calibrator "
+            "--depth=%d from\n"
+            "# %d positions of the archives; other evaluations need "
+            "their own.\n"
+            "#\n"
+            "# Every line has the phase of the game, the depth of the "
+            "deep search,\n"
+            "# the depth of the shallow search that predicts it, and the "
+            "slope,\n"
+            "# intercept and standard deviation of the prediction:\n"
+            "#\n"
+            "# phase  depth  shallow  slope  intercept  sigma\n",
+            evaluation, max_depth, num_searched);
+    for (int phase = 0; phase < NUM_PHASES; phase++)
+    {
+        for (int depth = MIN_PROBCUT_DEPTH; depth <= max_depth; depth++)
+        {
+            const Regression *r = &regressions[phase][depth];
+            double variance = r->n * r->xx - r->x * r->x;
+
+            if (r->n < MIN_SAMPLES || variance <= 0)
+                continue;
+
+            double slope = (r->n * r->xy - r->x * r->y) / variance;
+            double intercept = (r->y - slope * r->x) / r->n;
+            double squared_error =
+                r->yy - 2 * slope * r->xy - 2 * intercept * r->y +
+                slope * slope * r->xx + 2 * slope * intercept * r->x +
+                r->n * intercept * intercept;
+            double sigma = sqrt(fmax(squared_error, 0) / (r->n - 2));
+
+            if (slope <= 0)
+                continue;
+            fprintf(
+                    fp, "%d  %2d  %2d  %.4f  %8.3f  %8.3f\n", phase, depth,
+                    get_probcut_depth(depth), slope, intercept, sigma);
+        }
+    }
+    return fclose(fp) == 0;
+}
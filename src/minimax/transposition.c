@@ -0,0 +1,320 @@
+#include <stdlib.h>
+#include <string.h>
+#include "transposition.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// Seed for the Zobrist keys. Fixed, so that the keys are the same
+// on every run.
+#define ZOBRIST_SEED 0x2545f4914f6cdd1dULL
+
+// Size of a huge page. Tables at least this big are aligned to it,
+// so that the system can back them with huge pages.
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Plies of depth that an entry is worth less for every search
+// since the one that stored it.
+#define AGE_WEIGHT 8
+
+// Random keys for a white (index 0) or black (index 1) disc on
+// each square.
+static uint64_t disc_keys[2][NUM_SQUARES];
+
+// Keys for a disc that changes color on each square (the XOR of
+// the white and black keys).
+static uint64_t flip_keys[NUM_SQUARES];
+
+// Key for the maximizer (white) being the side to move.
+static uint64_t side_key;
+
+static uint64_t next_random(uint64_t *state);
+static uint64_t pack_entry(
+        int depth, int score, bound bound, int best_move);
+static void unpack_entry(uint64_t data, Transposition_entry *entry);
+static Transposition_slot *get_replaced_slot(
+        const Transposition_table *table, Transposition_slot *slots);
+static int get_entry_worth(
+        const Transposition_table *table, const Transposition_entry *entry);
+
+
+// Generates the Zobrist keys. Must be called once before hashing
+// any position.
+void init_zobrist_keys(void)
+{
+    uint64_t state = ZOBRIST_SEED;
+
+    for (int square = 0; square < NUM_SQUARES; square++)
+    {
+        disc_keys[0][square] = next_random(&state);
+        disc_keys[1][square] = next_random(&state);
+        flip_keys[square] = disc_keys[0][square] ^ disc_keys[1][square];
+    }
+    side_key = next_random(&state);
+}
+
+
+// Computes the Zobrist key of a position from scratch.
+//
+// Arguments:
+// The position.
+// Whether the side to move is the maximizer (white).
+uint64_t hash_position(const Position *position, char is_max)
+{
+    Bitboard white_discs = is_max ? position->player : position->opponent;
+    Bitboard black_discs = is_max ? position->opponent : position->player;
+    uint64_t hash = is_max ? side_key : 0;
+
+    while (white_discs)
+        hash ^= disc_keys[0][pop_first_square(&white_discs)];
+    while (black_discs)
+        hash ^= disc_keys[1][pop_first_square(&black_discs)];
+    return hash;
+}
+
+
+// Updates a Zobrist key with a move: the disc placed on the
+// square and the discs it flipped. The side to move is not
+// changed (see hash_switch_player()).
+//
+// Arguments:
+// The key of the position before the move.
+// The square where the move was made and the flipped discs.
+// Whether the player who made the move is the maximizer.
+uint64_t hash_move(uint64_t hash, int square, Bitboard flipped, char is_max)
+{
+    hash ^= disc_keys[is_max ? 0 : 1][square];
+    while (flipped)
+        hash ^= flip_keys[pop_first_square(&flipped)];
+    return hash;
+}
+
+
+// Updates a Zobrist key when the turn goes to the other player.
+uint64_t hash_switch_player(uint64_t hash)
+{
+    return hash ^ side_key;
+}
+
+
+// Allocates an empty table that uses (at most) the given amount
+// of memory. The number of buckets is rounded down to a power
+// of two.
+//
+// Big tables are aligned to huge pages and, on Linux, the system is
+// asked to back them with huge pages (when transparent huge pages
+// are enabled), which saves most of the TLB misses of the probes.
+//
+// Returns 1 on success and 0 if the memory couldn't be allocated.
+int create_transposition_table(Transposition_table *table, size_t megabytes)
+{
+    size_t max_buckets =
+        megabytes * 1024 * 1024 / sizeof(Transposition_bucket);
+    size_t num_buckets = 1;
+
+    while (num_buckets * 2 <= max_buckets)
+        num_buckets *= 2;
+
+    size_t size = num_buckets * sizeof(Transposition_bucket);
+    size_t alignment =
+        size >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : sizeof(Transposition_bucket);
+    void *buckets;
+
+    if (posix_memalign(&buckets, alignment, size))
+        return 0;
+#ifdef MADV_HUGEPAGE
+    if (size >= HUGE_PAGE_SIZE)
+        madvise(buckets, size, MADV_HUGEPAGE);
+#endif
+
+    table->buckets = buckets;
+    table->mask = num_buckets - 1;
+    table->size = size;
+    clear_transposition_table(table);
+    return 1;
+}
+
+
+// Forgets every position stored in the table.
+//
+// Generation 0 is never used, so the empty slots look like the
+// oldest entries there are.
+void clear_transposition_table(Transposition_table *table)
+{
+    memset(table->buckets, 0, table->size);
+    table->generation = 1;
+}
+
+
+void free_transposition_table(Transposition_table *table)
+{
+    free(table->buckets);
+    table->buckets = NULL;
+    table->mask = 0;
+    table->size = 0;
+}
+
+
+// Starts a new search: the entries stored until now become older
+// than the ones it will store.
+void start_table_generation(Transposition_table *table)
+{
+    if (!++table->generation)
+        table->generation = 1;
+}
+
+
+// Starts loading the bucket of a key into the cache, so that it is
+// there by the time the position is probed.
+void prefetch_transposition_table(
+        const Transposition_table *table, uint64_t key)
+{
+    __builtin_prefetch(&table->buckets[key & table->mask]);
+}
+
+
+// Looks up the entry stored for the given key and copies it.
+//
+// Returns 1 if the position is in the table and 0 if it isn't.
+int probe_transposition_table(
+        const Transposition_table *table, uint64_t key,
+        Transposition_entry *entry)
+{
+    const Transposition_slot *slots = table->buckets[key & table->mask].slots;
+
+    for (int i = 0; i < BUCKET_SLOTS; i++)
+    {
+        uint64_t data = slots[i].data;
+
+        if ((slots[i].check ^ data) == key)
+        {
+            entry->key = key;
+            unpack_entry(data, entry);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+// Stores the result of searching a position.
+//
+// An entry for the same position is replaced, unless it is deeper
+// and was stored by this search. Otherwise, the first slot of the
+// bucket takes the entry if it is at least as deep as the one there
+// (or that one is from an older search), and the entry it replaces
+// moves to one of the other slots. Entries that don't go in the
+// first slot replace the least valuable of the other ones.
+void store_transposition_table(
+        Transposition_table *table, uint64_t key, int depth, int score,
+        bound bound, int best_move)
+{
+    Transposition_slot *slots = table->buckets[key & table->mask].slots;
+    Transposition_entry old_entry;
+    uint64_t data = pack_entry(depth, score, bound, best_move) |
+        (uint64_t) table->generation << 56;
+
+    for (int i = 0; i < BUCKET_SLOTS; i++)
+    {
+        uint64_t old_data = slots[i].data;
+
+        if ((slots[i].check ^ old_data) == key)
+        {
+            unpack_entry(old_data, &old_entry);
+            if (
+                    old_entry.depth > depth &&
+                    old_entry.generation == table->generation)
+                return;
+            slots[i].check = key ^ data;
+            slots[i].data = data;
+            return;
+        }
+    }
+
+    Transposition_slot *slot = &slots[0];
+    Transposition_slot first = slots[0];
+
+    unpack_entry(first.data, &old_entry);
+    if (depth >= old_entry.depth || old_entry.generation != table->generation)
+    {
+        // The entry of this search that is pushed out of the first
+        // slot is still worth keeping.
+        if (old_entry.generation == table->generation)
+            *get_replaced_slot(table, slots) = first;
+    }
+    else
+        slot = get_replaced_slot(table, slots);
+
+    slot->check = key ^ data;
+    slot->data = data;
+}
+
+
+// Packs the fields of an entry in a single word: the score in the
+// low 32 bits, then the depth, the bound and the best move. The
+// generation goes in the top 8 bits.
+static uint64_t pack_entry(
+        int depth, int score, bound bound, int best_move)
+{
+    return (uint64_t) (uint32_t) score |
+        (uint64_t) (uint8_t) depth << 32 |
+        (uint64_t) (uint8_t) bound << 40 |
+        (uint64_t) (uint8_t) best_move << 48;
+}
+
+
+static void unpack_entry(uint64_t data, Transposition_entry *entry)
+{
+    entry->score = (int32_t) (uint32_t) data;
+    entry->depth = (int8_t) (data >> 32);
+    entry->bound = (uint8_t) (data >> 40);
+    entry->best_move = (int8_t) (data >> 48);
+    entry->generation = (uint8_t) (data >> 56);
+}
+
+
+// Returns the slot (other than the first one) with the least
+// valuable entry of a bucket.
+static Transposition_slot *get_replaced_slot(
+        const Transposition_table *table, Transposition_slot *slots)
+{
+    Transposition_slot *replaced = &slots[1];
+    Transposition_entry entry;
+
+    unpack_entry(replaced->data, &entry);
+    int lowest_worth = get_entry_worth(table, &entry);
+    for (int i = 2; i < BUCKET_SLOTS; i++)
+    {
+        unpack_entry(slots[i].data, &entry);
+        int worth = get_entry_worth(table, &entry);
+        if (worth < lowest_worth)
+        {
+            lowest_worth = worth;
+            replaced = &slots[i];
+        }
+    }
+    return replaced;
+}
+
+
+// Returns how valuable an entry is: deep searches are worth more,
+// and old ones less.
+static int get_entry_worth(
+        const Transposition_table *table, const Transposition_entry *entry)
+{
+    unsigned char age = table->generation - entry->generation;
+
+    return entry->depth - AGE_WEIGHT * age;
+}
+
+
+// Pseudo-random number generator (SplitMix64).
+static uint64_t next_random(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
@@ -0,0 +1,90 @@
+#ifndef _TRANSPOSITION_
+#define _TRANSPOSITION_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../bitboard/bitboard.h"
+
+// Default size of the transposition table, in megabytes.
+#define DEFAULT_HASH_SIZE 64
+
+// Value stored as the best move of an entry when there is none.
+#define NO_MOVE -1
+
+// Slots of a bucket of the table. A bucket takes one cache line.
+#define BUCKET_SLOTS 4
+
+// What the score of an entry tells about the real score of
+// the position.
+typedef enum bound
+{
+    exact = 0,
+    lower_bound = 1,
+    upper_bound = 2
+} bound;
+
+// A searched position. Scores are for the side to move (negamax
+// scores): the side key of hash_position() gives the same discs a
+// different key for each side, so an entry is only found by the
+// side that stored it. The depth is the number of plies that were
+// still left to search below the position. The generation tells
+// which search stored it.
+typedef struct Transposition_entry
+{
+    uint64_t key;
+    int score;
+    signed char depth;
+    unsigned char bound;
+    signed char best_move;
+    unsigned char generation;
+} Transposition_entry;
+
+// How an entry is stored in the table: the score, depth, bound,
+// best move and generation packed in one word, and the key XORed with that
+// word. An entry that is read while another thread is writing it
+// doesn't match its key, so the table needs no locks.
+typedef struct Transposition_slot
+{
+    uint64_t check;
+    uint64_t data;
+} Transposition_slot;
+
+// Slots for the positions whose keys have the same low bits. The
+// first one keeps the deepest searches and the other ones take
+// whatever doesn't fit there.
+typedef struct Transposition_bucket
+{
+    Transposition_slot slots[BUCKET_SLOTS];
+} __attribute__((aligned(64))) Transposition_bucket;
+
+// Fixed-size hash table of searched positions, indexed by the low
+// bits of their Zobrist keys. It can be shared by several threads.
+//
+// The generation goes up with every search, so that the entries
+// left by older searches are the first ones to be replaced.
+typedef struct Transposition_table
+{
+    Transposition_bucket *buckets;
+    uint64_t mask;
+    size_t size;
+    unsigned char generation;
+} Transposition_table;
+
+void init_zobrist_keys(void);
+uint64_t hash_position(const Position *position, char is_max);
+uint64_t hash_move(uint64_t hash, int square, Bitboard flipped, char is_max);
+uint64_t hash_switch_player(uint64_t hash);
+int create_transposition_table(Transposition_table *table, size_t megabytes);
+void clear_transposition_table(Transposition_table *table);
+void free_transposition_table(Transposition_table *table);
+void start_table_generation(Transposition_table *table);
+void prefetch_transposition_table(
+        const Transposition_table *table, uint64_t key);
+int probe_transposition_table(
+        const Transposition_table *table, uint64_t key,
+        Transposition_entry *entry);
+void store_transposition_table(
+        Transposition_table *table, uint64_t key, int depth, int score,
+        bound bound, int best_move);
+
+#endif
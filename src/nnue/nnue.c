@@ -0,0 +1,345 @@
+#include <stdio.h>
+#include <string.h>
+#include "nnue.h"
+
+// The AVX2 kernels are compiled on every x86 build and only used
+// when the processor has AVX2 (see select_kernels()), so the same
+// binary runs on any x86 processor.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NNUE_AVX2
+#include <immintrin.h>
+#endif
+
+// Inputs of the discs of each color on a square.
+#define BLACK_INPUT(square) (square)
+#define WHITE_INPUT(square) (NUM_SQUARES + (square))
+
+// The kernels of the network for one set of instructions.
+typedef struct Nnue_kernels
+{
+    const char *name;
+    void (*add_weights)(int16_t *values, const int16_t *weights);
+    void (*subtract_weights)(int16_t *values, const int16_t *weights);
+    int32_t (*dot_clipped)(const int16_t *values, const int16_t *weights);
+} Nnue_kernels;
+
+static void select_kernels(void);
+#ifdef NNUE_AVX2
+static void add_weights_avx2(int16_t *values, const int16_t *weights);
+static void subtract_weights_avx2(int16_t *values, const int16_t *weights);
+static int32_t dot_clipped_avx2(
+        const int16_t *values, const int16_t *weights);
+#endif
+#ifdef __SSE2__
+static void add_weights_sse2(int16_t *values, const int16_t *weights);
+static void subtract_weights_sse2(int16_t *values, const int16_t *weights);
+static int32_t dot_clipped_sse2(
+        const int16_t *values, const int16_t *weights);
+#endif
+static void add_weights_scalar(int16_t *values, const int16_t *weights);
+static void subtract_weights_scalar(int16_t *values, const int16_t *weights);
+static int32_t dot_clipped_scalar(
+        const int16_t *values, const int16_t *weights);
+
+#ifdef NNUE_AVX2
+static const Nnue_kernels avx2_kernels =
+{
+    "avx2", add_weights_avx2, subtract_weights_avx2, dot_clipped_avx2
+};
+#endif
+#ifdef __SSE2__
+static const Nnue_kernels sse2_kernels =
+{
+    "sse2", add_weights_sse2, subtract_weights_sse2, dot_clipped_sse2
+};
+#endif
+static const Nnue_kernels scalar_kernels =
+{
+    "scalar", add_weights_scalar, subtract_weights_scalar,
+    dot_clipped_scalar
+};
+
+// The kernels in use (the plain C ones until select_kernels() is
+// called).
+static const Nnue_kernels *kernels = &scalar_kernels;
+
+
+// Reads a network from a file.
+//
+// Returns 1 on success and 0 if the file couldn't be read or its
+// network doesn't have the size of this one.
+int load_network(Nnue_network *network, const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    Nnue_header header;
+
+    select_kernels();
+    if (!fp)
+        return 0;
+
+    int loaded =
+        fread(&header, sizeof(Nnue_header), 1, fp) == 1 &&
+        header.magic == NNUE_MAGIC &&
+        header.version == NNUE_VERSION &&
+        header.inputs == NNUE_INPUTS &&
+        header.hidden == NNUE_HIDDEN &&
+        header.num_phases == NUM_PHASES &&
+        fread(network, sizeof(Nnue_network), 1, fp) == 1;
+    fclose(fp);
+    return loaded;
+}
+
+
+// Computes the accumulator of a position from scratch.
+void refresh_accumulator(
+        const Nnue_network *network, Bitboard black, Bitboard white,
+        Nnue_accumulator *accumulator)
+{
+    memcpy(accumulator->values, network->input_biases,
+           sizeof(accumulator->values));
+    while (black)
+        kernels->add_weights(
+                accumulator->values,
+                network->input_weights[BLACK_INPUT(pop_first_square(&black))]);
+    while (white)
+        kernels->add_weights(
+                accumulator->values,
+                network->input_weights[WHITE_INPUT(pop_first_square(&white))]);
+}
+
+
+// Computes the accumulator after a move from the one before it.
+//
+// Arguments:
+// The network.
+// The accumulator before the move, and the one to fill.
+// The square of the move, the flipped discs and the color of the
+// player who moved.
+void update_accumulator(
+        const Nnue_network *network, const Nnue_accumulator *previous,
+        Nnue_accumulator *accumulator, int square, Bitboard flipped,
+        char white_moved)
+{
+    int16_t *values = accumulator->values;
+    int placed = white_moved ? WHITE_INPUT(0) : BLACK_INPUT(0);
+    int removed = white_moved ? BLACK_INPUT(0) : WHITE_INPUT(0);
+
+    *accumulator = *previous;
+    kernels->add_weights(values, network->input_weights[placed + square]);
+    while (flipped)
+    {
+        int flipped_square = pop_first_square(&flipped);
+
+        kernels->subtract_weights(
+                values, network->input_weights[removed + flipped_square]);
+        kernels->add_weights(
+                values, network->input_weights[placed + flipped_square]);
+    }
+}
+
+
+// Runs the output layer of the network on an accumulator.
+//
+// Arguments:
+// The network.
+// The accumulator of the position.
+// The number of empty squares of the position (for the phase).
+//
+// Returns how many discs black is expected to win by, in units of
+// NNUE_DISC_VALUE.
+int evaluate_network(
+        const Nnue_network *network, const Nnue_accumulator *accumulator,
+        int empties)
+{
+    int phase = get_game_phase(empties);
+    int32_t output =
+        kernels->dot_clipped(
+                accumulator->values, network->output_weights[phase]) +
+        network->output_biases[phase];
+
+    return (int64_t) output * NNUE_TARGET_SCALE * NNUE_DISC_VALUE /
+        (NNUE_ACTIVATION_SCALE * NNUE_OUTPUT_SCALE);
+}
+
+
+// Returns the name of the instructions the kernels use.
+const char *get_nnue_kernels(void)
+{
+    select_kernels();
+    return kernels->name;
+}
+
+
+// Picks the fastest kernels that the processor can run. Called
+// when a network is loaded, before any search uses it.
+static void select_kernels(void)
+{
+#ifdef __SSE2__
+    kernels = &sse2_kernels;
+#endif
+#ifdef NNUE_AVX2
+    if (__builtin_cpu_supports("avx2"))
+        kernels = &avx2_kernels;
+#endif
+}
+
+
+#ifdef NNUE_AVX2
+
+// Kernels with 16 neurons per instruction.
+
+__attribute__((target("avx2")))
+static void add_weights_avx2(int16_t *values, const int16_t *weights)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i += 16)
+    {
+        __m256i sum = _mm256_add_epi16(
+                _mm256_load_si256((const __m256i *) (values + i)),
+                _mm256_loadu_si256((const __m256i *) (weights + i)));
+        _mm256_store_si256((__m256i *) (values + i), sum);
+    }
+}
+
+
+__attribute__((target("avx2")))
+static void subtract_weights_avx2(int16_t *values, const int16_t *weights)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i += 16)
+    {
+        __m256i difference = _mm256_sub_epi16(
+                _mm256_load_si256((const __m256i *) (values + i)),
+                _mm256_loadu_si256((const __m256i *) (weights + i)));
+        _mm256_store_si256((__m256i *) (values + i), difference);
+    }
+}
+
+
+// Clamps the values between 0 and NNUE_ACTIVATION_SCALE and
+// multiplies them by the weights, adding up the products.
+__attribute__((target("avx2")))
+static int32_t dot_clipped_avx2(
+        const int16_t *values, const int16_t *weights)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi16(NNUE_ACTIVATION_SCALE);
+    __m256i sum = _mm256_setzero_si256();
+
+    for (int i = 0; i < NNUE_HIDDEN; i += 16)
+    {
+        __m256i activations = _mm256_min_epi16(
+                _mm256_max_epi16(
+                    _mm256_load_si256((const __m256i *) (values + i)),
+                    zero),
+                one);
+
+        // Pairs of products are added into 32 bits.
+        sum = _mm256_add_epi32(
+                sum,
+                _mm256_madd_epi16(
+                    activations,
+                    _mm256_loadu_si256((const __m256i *) (weights + i))));
+    }
+
+    __m128i half = _mm_add_epi32(
+            _mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4e));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xb1));
+    return _mm_cvtsi128_si32(half);
+}
+
+#endif
+
+#ifdef __SSE2__
+
+// Kernels with 8 neurons per instruction.
+
+static void add_weights_sse2(int16_t *values, const int16_t *weights)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i += 8)
+    {
+        __m128i sum = _mm_add_epi16(
+                _mm_load_si128((const __m128i *) (values + i)),
+                _mm_loadu_si128((const __m128i *) (weights + i)));
+        _mm_store_si128((__m128i *) (values + i), sum);
+    }
+}
+
+
+static void subtract_weights_sse2(int16_t *values, const int16_t *weights)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i += 8)
+    {
+        __m128i difference = _mm_sub_epi16(
+                _mm_load_si128((const __m128i *) (values + i)),
+                _mm_loadu_si128((const __m128i *) (weights + i)));
+        _mm_store_si128((__m128i *) (values + i), difference);
+    }
+}
+
+
+// Clamps the values between 0 and NNUE_ACTIVATION_SCALE and
+// multiplies them by the weights, adding up the products.
+static int32_t dot_clipped_sse2(
+        const int16_t *values, const int16_t *weights)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(NNUE_ACTIVATION_SCALE);
+    __m128i sum = _mm_setzero_si128();
+
+    for (int i = 0; i < NNUE_HIDDEN; i += 8)
+    {
+        __m128i activations = _mm_min_epi16(
+                _mm_max_epi16(
+                    _mm_load_si128((const __m128i *) (values + i)), zero),
+                one);
+
+        // Pairs of products are added into 32 bits.
+        sum = _mm_add_epi32(
+                sum,
+                _mm_madd_epi16(
+                    activations,
+                    _mm_loadu_si128((const __m128i *) (weights + i))));
+    }
+
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+#endif
+
+// Kernels for processors without vector instructions.
+
+static void add_weights_scalar(int16_t *values, const int16_t *weights)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i++)
+        values[i] += weights[i];
+}
+
+
+static void subtract_weights_scalar(int16_t *values, const int16_t *weights)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i++)
+        values[i] -= weights[i];
+}
+
+
+// Clamps the values between 0 and NNUE_ACTIVATION_SCALE and
+// multiplies them by the weights, adding up the products.
+static int32_t dot_clipped_scalar(
+        const int16_t *values, const int16_t *weights)
+{
+    int32_t sum = 0;
+
+    for (int i = 0; i < NNUE_HIDDEN; i++)
+    {
+        int16_t activation = values[i];
+
+        if (activation < 0)
+            activation = 0;
+        else if (activation > NNUE_ACTIVATION_SCALE)
+            activation = NNUE_ACTIVATION_SCALE;
+        sum += activation * weights[i];
+    }
+    return sum;
+}
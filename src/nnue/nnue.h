@@ -0,0 +1,74 @@
+#ifndef _NNUE_
+#define _NNUE_
+
+#include <stdint.h>
+#include "../bitboard/bitboard.h"
+#include "../minimax/evaluation.h"
+
+// Identifies the files of networks ("RVNN"), and the version of
+// their format.
+#define NNUE_MAGIC 0x4e4e5652
+#define NNUE_VERSION 1
+
+// Inputs of the network (a black and a white disc for every square)
+// and neurons of its hidden layer.
+#define NNUE_INPUTS (2 * NUM_SQUARES)
+#define NNUE_HIDDEN 128
+
+// Quantization: a hidden neuron is active between 0 and
+// NNUE_ACTIVATION_SCALE, and the output weights are multiplied by
+// NNUE_OUTPUT_SCALE.
+#define NNUE_ACTIVATION_SCALE 127
+#define NNUE_OUTPUT_SCALE 64
+
+// Discs of final difference for an output of 1 of the network
+// before quantization.
+#define NNUE_TARGET_SCALE 64
+
+// Value of a disc of final difference in the evaluations.
+#define NNUE_DISC_VALUE 32
+
+// Header at the beginning of a network file. It is followed by the
+// weights in the order of Nnue_network.
+typedef struct Nnue_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t inputs;
+    uint32_t hidden;
+    uint32_t num_phases;
+} Nnue_header;
+
+// A network with one hidden layer (clipped ReLU) and an output for
+// every phase of the game. It tells how many discs black is
+// expected to win by.
+typedef struct Nnue_network
+{
+    int16_t input_weights[NNUE_INPUTS][NNUE_HIDDEN];
+    int16_t input_biases[NNUE_HIDDEN];
+    int16_t output_weights[NUM_PHASES][NNUE_HIDDEN];
+    int32_t output_biases[NUM_PHASES];
+} Nnue_network;
+
+// Values of the hidden layer before the activation, for the discs
+// of a position. Moves add and subtract the weights of the discs
+// that change instead of adding up every disc again.
+typedef struct Nnue_accumulator
+{
+    int16_t values[NNUE_HIDDEN];
+} __attribute__((aligned(32))) Nnue_accumulator;
+
+int load_network(Nnue_network *network, const char *path);
+void refresh_accumulator(
+        const Nnue_network *network, Bitboard black, Bitboard white,
+        Nnue_accumulator *accumulator);
+void update_accumulator(
+        const Nnue_network *network, const Nnue_accumulator *previous,
+        Nnue_accumulator *accumulator, int square, Bitboard flipped,
+        char white_moved);
+int evaluate_network(
+        const Nnue_network *network, const Nnue_accumulator *accumulator,
+        int empties);
+const char *get_nnue_kernels(void);
+
+#endif
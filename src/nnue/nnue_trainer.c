@@ -0,0 +1,295 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "nnue.h"
+#include "../book/archive.h"
+#include "../book/book.h"
+
+// Default number of passes over the positions, and learning rate.
+#define DEFAULT_EPOCHS 20
+#define DEFAULT_RATE 0.002
+
+// Greatest input weight (and bias), so that the accumulator can't
+// overflow 16 bits even with every square taken.
+#define MAX_INPUT_WEIGHT 3.5
+
+// The network being trained, before quantization.
+typedef struct Float_network
+{
+    float input_weights[NNUE_INPUTS][NNUE_HIDDEN];
+    float input_biases[NNUE_HIDDEN];
+    float output_weights[NUM_PHASES][NNUE_HIDDEN];
+    float output_biases[NUM_PHASES];
+} Float_network;
+
+static void init_network(Float_network *network);
+static double train_sample(
+        Float_network *network, Bitboard black, Bitboard white, int score,
+        double rate);
+static double random_weight(double limit);
+static int write_network(const char *path, const Float_network *network);
+static int16_t quantize(double value, double limit);
+
+
+// Trains the network of the evaluation from archives of games.
+//
+// Every position of every game is scored by the final disc
+// difference of its game, and the network is fitted to predict it
+// with stochastic gradient descent. Every position is learned in a
+// random symmetry, and also with the colors swapped.
+//
+// The archives have a complete game on every line, written as the
+// moves played from the start (like "F5D6C3D3C4..."), with black
+// moving first and passes left out. Empty lines and lines starting
+// with '#' are skipped (see read_archive()).
+//
+// Usage: nnue_trainer [--epochs=N] [--rate=R] NETWORK ARCHIVE...
+int main(int argc, char **argv)
+{
+    Position_list list = { NULL, 0, 0 };
+    int epochs = DEFAULT_EPOCHS;
+    double rate = DEFAULT_RATE;
+    int first_file = 1;
+    int num_games = 0;
+
+    while (first_file < argc)
+    {
+        if (sscanf(argv[first_file], "--epochs=%d", &epochs) == 1)
+            first_file++;
+        else if (sscanf(argv[first_file], "--rate=%lf", &rate) == 1)
+            first_file++;
+        else
+            break;
+    }
+    if (argc - first_file < 2 || epochs <= 0 || rate <= 0)
+    {
+        fprintf(
+                stderr,
+                "Usage: %s [--epochs=N] [--rate=R] NETWORK ARCHIVE...\n",
+                argv[0]);
+        return 1;
+    }
+
+    init_bitboard();
+
+    // Read every game of every archive.
+    for (int i = first_file + 1; i < argc; i++)
+    {
+        int result = read_archive(argv[i], add_scored_positions, &list);
+
+        if (result < 0)
+            return 1;
+        num_games += result;
+    }
+    printf("%d games, %zu positions.\n", num_games, list.num_positions);
+
+    Float_network *network = malloc(sizeof(Float_network));
+    if (!network)
+    {
+        fprintf(stderr, "Out of memory.\n");
+        return 1;
+    }
+    init_network(network);
+
+    for (int epoch = 1; epoch <= epochs; epoch++)
+    {
+        double squared_error = 0;
+
+        shuffle_game_positions(list.positions, list.num_positions);
+        for (size_t i = 0; i < list.num_positions; i++)
+        {
+            const Game_position *sample = &list.positions[i];
+            int symmetry = rand() % NUM_SYMMETRIES;
+            Bitboard black = transform_bitboard(sample->black, symmetry);
+            Bitboard white = transform_bitboard(sample->white, symmetry);
+
+            squared_error += train_sample(
+                    network, black, white, sample->score, rate);
+            squared_error += train_sample(
+                    network, white, black, -sample->score, rate);
+        }
+
+        // Root mean squared error of the predictions, in discs.
+        printf(
+                "epoch %d: error %.2f discs\n", epoch,
+                list.num_positions ? NNUE_TARGET_SCALE *
+                sqrt(squared_error / (2 * list.num_positions)) : 0.0);
+    }
+
+    if (!write_network(argv[first_file], network))
+    {
+        fprintf(stderr, "Could not write %s.\n", argv[first_file]);
+        return 1;
+    }
+    printf(
+            "Network written to %s (kernels: %s).\n",
+            argv[first_file], get_nnue_kernels());
+
+    free(network);
+    free(list.positions);
+    return 0;
+}
+
+
+// Starts the network with small random weights, and the hidden
+// neurons halfway through their active range.
+static void init_network(Float_network *network)
+{
+    for (int i = 0; i < NNUE_INPUTS; i++)
+        for (int j = 0; j < NNUE_HIDDEN; j++)
+            network->input_weights[i][j] = random_weight(0.1);
+    for (int j = 0; j < NNUE_HIDDEN; j++)
+        network->input_biases[j] = 0.5;
+    for (int phase = 0; phase < NUM_PHASES; phase++)
+    {
+        for (int j = 0; j < NNUE_HIDDEN; j++)
+            network->output_weights[phase][j] = random_weight(0.1);
+        network->output_biases[phase] = 0;
+    }
+}
+
+
+// Moves the weights of the network towards the score of a
+// position.
+//
+// Arguments:
+// The network.
+// The position, by color.
+// The final disc difference for black.
+// The learning rate.
+//
+// Returns the squared error of the prediction before the update,
+// in units of NNUE_TARGET_SCALE discs.
+static double train_sample(
+        Float_network *network, Bitboard black, Bitboard white, int score,
+        double rate)
+{
+    int inputs[NUM_SQUARES];
+    int num_inputs = 0;
+    float hidden[NNUE_HIDDEN];
+    int phase = get_game_phase(count_discs(~(black | white)));
+    float *output_weights = network->output_weights[phase];
+
+    while (black)
+        inputs[num_inputs++] = pop_first_square(&black);
+    while (white)
+        inputs[num_inputs++] = NUM_SQUARES + pop_first_square(&white);
+
+    // Forward pass.
+    memcpy(hidden, network->input_biases, sizeof(hidden));
+    for (int i = 0; i < num_inputs; i++)
+    {
+        const float *weights = network->input_weights[inputs[i]];
+        for (int j = 0; j < NNUE_HIDDEN; j++)
+            hidden[j] += weights[j];
+    }
+
+    double output = network->output_biases[phase];
+    for (int j = 0; j < NNUE_HIDDEN; j++)
+        if (hidden[j] > 0)
+            output += output_weights[j] * (hidden[j] < 1 ? hidden[j] : 1);
+
+    // Backward pass. Only the neurons that aren't clipped pass the
+    // error to the inputs.
+    double error = (double) score / NNUE_TARGET_SCALE - output;
+    float step = rate * error;
+    float gradients[NNUE_HIDDEN];
+
+    for (int j = 0; j < NNUE_HIDDEN; j++)
+    {
+        float activation = hidden[j] <= 0 ? 0 : hidden[j] < 1 ? hidden[j] : 1;
+
+        gradients[j] = hidden[j] > 0 && hidden[j] < 1 ?
+            step * output_weights[j] : 0;
+        output_weights[j] += step * activation;
+        network->input_biases[j] += gradients[j];
+        if (network->input_biases[j] > MAX_INPUT_WEIGHT)
+            network->input_biases[j] = MAX_INPUT_WEIGHT;
+        else if (network->input_biases[j] < -MAX_INPUT_WEIGHT)
+            network->input_biases[j] = -MAX_INPUT_WEIGHT;
+    }
+    network->output_biases[phase] += step;
+
+    for (int i = 0; i < num_inputs; i++)
+    {
+        float *weights = network->input_weights[inputs[i]];
+        for (int j = 0; j < NNUE_HIDDEN; j++)
+        {
+            weights[j] += gradients[j];
+            if (weights[j] > MAX_INPUT_WEIGHT)
+                weights[j] = MAX_INPUT_WEIGHT;
+            else if (weights[j] < -MAX_INPUT_WEIGHT)
+                weights[j] = -MAX_INPUT_WEIGHT;
+        }
+    }
+    return error * error;
+}
+
+
+// Returns a random weight between -limit and limit.
+static double random_weight(double limit)
+{
+    return limit * (2.0 * rand() / RAND_MAX - 1);
+}
+
+
+// Writes the header and the quantized network.
+//
+// Returns 1 on success and 0 on failure.
+static int write_network(const char *path, const Float_network *network)
+{
+    Nnue_header header =
+    {
+        NNUE_MAGIC, NNUE_VERSION, NNUE_INPUTS, NNUE_HIDDEN, NUM_PHASES
+    };
+    Nnue_network *quantized = malloc(sizeof(Nnue_network));
+    FILE *fp;
+
+    if (!quantized)
+        return 0;
+
+    // The hidden layer is scaled so that a fully active neuron is
+    // NNUE_ACTIVATION_SCALE, and the output layer by
+    // NNUE_OUTPUT_SCALE on top of that.
+    for (int i = 0; i < NNUE_INPUTS; i++)
+        for (int j = 0; j < NNUE_HIDDEN; j++)
+            quantized->input_weights[i][j] = quantize(
+                    network->input_weights[i][j] * NNUE_ACTIVATION_SCALE,
+                    INT16_MAX);
+    for (int j = 0; j < NNUE_HIDDEN; j++)
+        quantized->input_biases[j] = quantize(
+                network->input_biases[j] * NNUE_ACTIVATION_SCALE,
+                INT16_MAX);
+    for (int phase = 0; phase < NUM_PHASES; phase++)
+    {
+        for (int j = 0; j < NNUE_HIDDEN; j++)
+            quantized->output_weights[phase][j] = quantize(
+                    network->output_weights[phase][j] * NNUE_OUTPUT_SCALE,
+                    INT16_MAX);
+        quantized->output_biases[phase] = (int32_t) lround(
+                network->output_biases[phase] *
+                NNUE_ACTIVATION_SCALE * NNUE_OUTPUT_SCALE);
+    }
+
+    fp = fopen(path, "wb");
+    int written =
+        fp &&
+        fwrite(&header, sizeof(Nnue_header), 1, fp) == 1 &&
+        fwrite(quantized, sizeof(Nnue_network), 1, fp) == 1;
+    if (fp && fclose(fp) != 0)
+        written = 0;
+    free(quantized);
+    return written;
+}
+
+
+// Rounds a weight to an integer between -limit and limit.
+static int16_t quantize(double value, double limit)
+{
+    if (value > limit)
+        return limit;
+    else if (value < -limit)
+        return -limit;
+    return (int16_t) lround(value);
+}
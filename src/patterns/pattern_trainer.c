@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "patterns.h"
+#include "../book/archive.h"
+#include "../minimax/evaluation.h"
+
+// Default number of passes over the positions, and learning rate.
+#define DEFAULT_EPOCHS 20
+#define DEFAULT_RATE 0.005
+
+static double train_sample(
+        float *weights, Bitboard black, Bitboard white, int score,
+        double rate);
+static int write_tables(const char *path, const float *weights);
+
+
+// Learns the weights of the pattern tables from archives of games.
+//
+// Every position of every game is scored by the final disc
+// difference of its game, and the weights are fitted to predict it
+// with stochastic gradient descent. Every position is also learned
+// with the colors swapped.
+//
+// The archives have a complete game on every line, written as the
+// moves played from the start (like "F5D6C3D3C4..."), with black
+// moving first and passes left out. Empty lines and lines starting
+// with '#' are skipped (see read_archive()).
+//
+// Usage: pattern_trainer [--epochs=N] [--rate=R] TABLES ARCHIVE...
+int main(int argc, char **argv)
+{
+    Position_list list = { NULL, 0, 0 };
+    int epochs = DEFAULT_EPOCHS;
+    double rate = DEFAULT_RATE;
+    int first_file = 1;
+    int num_games = 0;
+
+    while (first_file < argc)
+    {
+        if (sscanf(argv[first_file], "--epochs=%d", &epochs) == 1)
+            first_file++;
+        else if (sscanf(argv[first_file], "--rate=%lf", &rate) == 1)
+            first_file++;
+        else
+            break;
+    }
+    if (argc - first_file < 2 || epochs <= 0 || rate <= 0)
+    {
+        fprintf(
+                stderr,
+                "Usage: %s [--epochs=N] [--rate=R] TABLES ARCHIVE...\n",
+                argv[0]);
+        return 1;
+    }
+
+    init_bitboard();
+    init_patterns();
+
+    // Read every game of every archive.
+    for (int i = first_file + 1; i < argc; i++)
+    {
+        int result = read_archive(argv[i], add_scored_positions, &list);
+
+        if (result < 0)
+            return 1;
+        num_games += result;
+    }
+    printf("%d games, %zu positions.\n", num_games, list.num_positions);
+
+    float *weights =
+        calloc((size_t) NUM_PHASES * PATTERN_PHASE_SIZE, sizeof(float));
+    if (!weights)
+    {
+        fprintf(stderr, "Out of memory.\n");
+        return 1;
+    }
+
+    for (int epoch = 1; epoch <= epochs; epoch++)
+    {
+        double squared_error = 0;
+
+        shuffle_game_positions(list.positions, list.num_positions);
+        for (size_t i = 0; i < list.num_positions; i++)
+        {
+            const Game_position *sample = &list.positions[i];
+
+            squared_error += train_sample(
+                    weights, sample->black, sample->white, sample->score,
+                    rate);
+            squared_error += train_sample(
+                    weights, sample->white, sample->black, -sample->score,
+                    rate);
+        }
+
+        // Root mean squared error of the predictions, in discs.
+        printf(
+                "epoch %d: error %.2f discs\n", epoch,
+                list.num_positions ?
+                sqrt(squared_error / (2 * list.num_positions)) : 0.0);
+    }
+
+    if (!write_tables(argv[first_file], weights))
+    {
+        fprintf(stderr, "Could not write %s.\n", argv[first_file]);
+        return 1;
+    }
+    printf("Pattern tables written to %s.\n", argv[first_file]);
+
+    free(weights);
+    free(list.positions);
+    return 0;
+}
+
+
+// Moves the weights of the patterns of a position towards its
+// score.
+//
+// Arguments:
+// The weights of every phase, in discs.
+// The position, by color.
+// The final disc difference for black.
+// The learning rate.
+//
+// Returns the squared error of the prediction before the update.
+static double train_sample(
+        float *weights, Bitboard black, Bitboard white, int score,
+        double rate)
+{
+    Pattern_indices indices;
+    int offsets[NUM_PATTERNS];
+    int empties = count_discs(~(black | white));
+    float *phase_weights =
+        weights + (size_t) get_game_phase(empties) * PATTERN_PHASE_SIZE;
+    double prediction = 0;
+
+    compute_pattern_indices(black, white, &indices);
+    for (int pattern = 0; pattern < NUM_PATTERNS; pattern++)
+    {
+        offsets[pattern] = get_pattern_offset(&indices, pattern);
+        prediction += phase_weights[offsets[pattern]];
+    }
+
+    double error = score - prediction;
+    for (int pattern = 0; pattern < NUM_PATTERNS; pattern++)
+        phase_weights[offsets[pattern]] += rate * error;
+    return error * error;
+}
+
+
+// Writes the header and the weights of every phase, rounded to
+// units of PATTERN_DISC_VALUE.
+//
+// Returns 1 on success and 0 on failure.
+static int write_tables(const char *path, const float *weights)
+{
+    Pattern_header header =
+    {
+        PATTERNS_MAGIC, PATTERNS_VERSION, NUM_PHASES, PATTERN_PHASE_SIZE
+    };
+    FILE *fp = fopen(path, "wb");
+
+    if (!fp)
+        return 0;
+    if (fwrite(&header, sizeof(Pattern_header), 1, fp) != 1)
+    {
+        fclose(fp);
+        return 0;
+    }
+
+    for (size_t i = 0; i < (size_t) NUM_PHASES * PATTERN_PHASE_SIZE; i++)
+    {
+        double value = weights[i] * PATTERN_DISC_VALUE;
+        int16_t weight;
+
+        if (value > INT16_MAX)
+            weight = INT16_MAX;
+        else if (value < INT16_MIN)
+            weight = INT16_MIN;
+        else
+            weight = (int16_t) (value < 0 ? value - 0.5 : value + 0.5);
+
+        if (fwrite(&weight, sizeof(int16_t), 1, fp) != 1)
+        {
+            fclose(fp);
+            return 0;
+        }
+    }
+    return fclose(fp) == 0;
+}
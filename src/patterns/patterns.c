@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "patterns.h"
+#include "../book/book.h"
+#include "../minimax/evaluation.h"
+
+// Greatest number of patterns a square is part of.
+#define MAX_SQUARE_PATTERNS 8
+
+// Digits of the squares in the indices.
+#define BLACK_DIGIT 1
+#define WHITE_DIGIT 2
+
+// A kind of pattern: its squares in one of its orientations, and
+// how many different orientations there are on the board.
+typedef struct Pattern_type
+{
+    int size;
+    int squares[MAX_PATTERN_SIZE];
+    int num_orientations;
+} Pattern_type;
+
+// A pattern of a square: which one, and the power of 3 of the
+// square in its index.
+typedef struct Square_pattern
+{
+    int pattern;
+    int power;
+} Square_pattern;
+
+static const Pattern_type pattern_types[NUM_PATTERN_TYPES] = {
+    // Edge and the X-squares: A1 to H1, B2 and G2.
+    {10, {0, 1, 2, 3, 4, 5, 6, 7, 9, 14}, 4},
+
+    // Corner 3x3: A1 to C3.
+    {9, {0, 1, 2, 8, 9, 10, 16, 17, 18}, 4},
+
+    // Corner 2x5: A1 to E2.
+    {10, {0, 1, 2, 3, 4, 8, 9, 10, 11, 12}, 8},
+
+    // Diagonals: A1 to H8, B1 to H7, C1 to H6, D1 to H5 and E1 to
+    // H4.
+    {8, {0, 9, 18, 27, 36, 45, 54, 63}, 2},
+    {7, {1, 10, 19, 28, 37, 46, 55}, 4},
+    {6, {2, 11, 20, 29, 38, 47}, 4},
+    {5, {3, 12, 21, 30, 39}, 4},
+    {4, {4, 13, 22, 31}, 4}
+};
+
+// Squares of every pattern on the board, in the order of the
+// digits of its index, and the kind of pattern.
+static int pattern_squares[NUM_PATTERNS][MAX_PATTERN_SIZE];
+static int pattern_sizes[NUM_PATTERNS];
+static int pattern_kinds[NUM_PATTERNS];
+
+// Where the weights of every kind of pattern start in the table of
+// a phase.
+static int type_offsets[NUM_PATTERN_TYPES];
+
+// Patterns that every square is part of, to update the indices
+// after a move.
+static Square_pattern square_patterns[NUM_SQUARES][MAX_SQUARE_PATTERNS];
+static int num_square_patterns[NUM_SQUARES];
+
+static void update_indices(
+        Pattern_indices *indices, int square, Bitboard flipped,
+        int placed, int change);
+
+
+// Finds every pattern on the board from the patterns of
+// pattern_types[]. Must be called once before using the rest of
+// the functions.
+void init_patterns(void)
+{
+    int num_patterns = 0;
+    int offset = 0;
+
+    for (int square = 0; square < NUM_SQUARES; square++)
+        num_square_patterns[square] = 0;
+
+    for (int type = 0; type < NUM_PATTERN_TYPES; type++)
+    {
+        const Pattern_type *pattern_type = &pattern_types[type];
+        Bitboard orientations[NUM_SYMMETRIES];
+        int num_orientations = 0;
+
+        type_offsets[type] = offset;
+        int num_configurations = 1;
+        for (int i = 0; i < pattern_type->size; i++)
+            num_configurations *= 3;
+        offset += num_configurations;
+
+        // Some symmetries give the same squares again (for example,
+        // mirroring an edge), so only the new ones are added.
+        for (int symmetry = 0; symmetry < NUM_SYMMETRIES; symmetry++)
+        {
+            int squares[MAX_PATTERN_SIZE];
+            Bitboard mask = 0;
+
+            for (int i = 0; i < pattern_type->size; i++)
+            {
+                Bitboard square = transform_bitboard(
+                        SQUARE_BIT(pattern_type->squares[i]), symmetry);
+
+                squares[i] = pop_first_square(&square);
+                mask |= SQUARE_BIT(squares[i]);
+            }
+
+            int is_new = TRUE;
+            for (int i = 0; i < num_orientations; i++)
+                if (orientations[i] == mask)
+                    is_new = FALSE;
+            if (!is_new)
+                continue;
+            orientations[num_orientations++] = mask;
+
+            int power = 1;
+            for (int i = 0; i < pattern_type->size; i++)
+            {
+                int square = squares[i];
+                Square_pattern *square_pattern =
+                    &square_patterns[square][num_square_patterns[square]++];
+
+                pattern_squares[num_patterns][i] = square;
+                square_pattern->pattern = num_patterns;
+                square_pattern->power = power;
+                power *= 3;
+            }
+            pattern_sizes[num_patterns] = pattern_type->size;
+            pattern_kinds[num_patterns] = type;
+            num_patterns++;
+        }
+    }
+}
+
+
+// Reads the pattern tables from a file.
+//
+// Returns 1 on success and 0 if the file couldn't be read, isn't a
+// file of pattern tables or there wasn't enough memory.
+int load_pattern_tables(Pattern_tables *tables, const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    Pattern_header header;
+    size_t num_weights = (size_t) NUM_PHASES * PATTERN_PHASE_SIZE;
+
+    if (!fp)
+        return 0;
+    if (
+            fread(&header, sizeof(Pattern_header), 1, fp) != 1 ||
+            header.magic != PATTERNS_MAGIC ||
+            header.version != PATTERNS_VERSION ||
+            header.num_phases != NUM_PHASES ||
+            header.phase_size != PATTERN_PHASE_SIZE)
+    {
+        fclose(fp);
+        return 0;
+    }
+
+    int16_t *weights = malloc(num_weights * sizeof(int16_t));
+    if (!weights || fread(weights, sizeof(int16_t), num_weights, fp) !=
+            num_weights)
+    {
+        free(weights);
+        fclose(fp);
+        return 0;
+    }
+    fclose(fp);
+
+    tables->weights = weights;
+    return 1;
+}
+
+
+void free_pattern_tables(Pattern_tables *tables)
+{
+    free(tables->weights);
+    tables->weights = NULL;
+}
+
+
+// Computes the index of every pattern of a position from scratch.
+void compute_pattern_indices(
+        Bitboard black, Bitboard white, Pattern_indices *indices)
+{
+    for (int pattern = 0; pattern < NUM_PATTERNS; pattern++)
+    {
+        int index = 0;
+
+        // The first square is the least significant digit.
+        for (int i = pattern_sizes[pattern] - 1; i >= 0; i--)
+        {
+            Bitboard square = SQUARE_BIT(pattern_squares[pattern][i]);
+
+            index *= 3;
+            if (black & square)
+                index += BLACK_DIGIT;
+            else if (white & square)
+                index += WHITE_DIGIT;
+        }
+        indices->indices[pattern] = index;
+    }
+}
+
+
+// Updates the indices after a move: the square of the move goes
+// from empty to the color of the player and the flipped discs from
+// the other color to it.
+void update_pattern_indices(
+        Pattern_indices *indices, int square, Bitboard flipped,
+        char white_moved)
+{
+    if (white_moved)
+        update_indices(
+                indices, square, flipped, WHITE_DIGIT,
+                WHITE_DIGIT - BLACK_DIGIT);
+    else
+        update_indices(
+                indices, square, flipped, BLACK_DIGIT,
+                BLACK_DIGIT - WHITE_DIGIT);
+}
+
+
+// Takes back the changes of update_pattern_indices() for the same
+// move.
+void restore_pattern_indices(
+        Pattern_indices *indices, int square, Bitboard flipped,
+        char white_moved)
+{
+    if (white_moved)
+        update_indices(
+                indices, square, flipped, -WHITE_DIGIT,
+                BLACK_DIGIT - WHITE_DIGIT);
+    else
+        update_indices(
+                indices, square, flipped, -BLACK_DIGIT,
+                WHITE_DIGIT - BLACK_DIGIT);
+}
+
+
+// Adds the changes of the digits of the squares of a move to the
+// indices of their patterns.
+//
+// Arguments:
+// The indices.
+// The square of the move and the flipped discs.
+// The change of the digit of the square of the move, and of the
+// digits of the flipped discs.
+static void update_indices(
+        Pattern_indices *indices, int square, Bitboard flipped,
+        int placed, int change)
+{
+    for (int i = 0; i < num_square_patterns[square]; i++)
+    {
+        const Square_pattern *square_pattern = &square_patterns[square][i];
+        indices->indices[square_pattern->pattern] +=
+            placed * square_pattern->power;
+    }
+
+    while (flipped)
+    {
+        int flipped_square = pop_first_square(&flipped);
+
+        for (int i = 0; i < num_square_patterns[flipped_square]; i++)
+        {
+            const Square_pattern *square_pattern =
+                &square_patterns[flipped_square][i];
+            indices->indices[square_pattern->pattern] +=
+                change * square_pattern->power;
+        }
+    }
+}
+
+
+// Returns where the weight of the configuration of a pattern is in
+// the table of a phase.
+int get_pattern_offset(const Pattern_indices *indices, int pattern)
+{
+    return type_offsets[pattern_kinds[pattern]] + indices->indices[pattern];
+}
+
+
+// Adds up the weights of the configurations of every pattern.
+//
+// Arguments:
+// The tables.
+// The indices of the patterns of the position.
+// The number of empty squares of the position (for the phase).
+//
+// Returns how many discs black is expected to win by, in units of
+// PATTERN_DISC_VALUE.
+int evaluate_patterns(
+        const Pattern_tables *tables, const Pattern_indices *indices,
+        int empties)
+{
+    const int16_t *weights =
+        tables->weights + (size_t) get_game_phase(empties) *
+        PATTERN_PHASE_SIZE;
+    int score = 0;
+
+    for (int pattern = 0; pattern < NUM_PATTERNS; pattern++)
+        score += weights[get_pattern_offset(indices, pattern)];
+    return score;
+}
@@ -0,0 +1,71 @@
+#ifndef _PATTERNS_
+#define _PATTERNS_
+
+#include <stdint.h>
+#include "../bitboard/bitboard.h"
+
+// Identifies the files of pattern tables ("RVPT"), and the version
+// of their format.
+#define PATTERNS_MAGIC 0x54505652
+#define PATTERNS_VERSION 1
+
+// Kinds of patterns (edge with the X-squares, corner 3x3, corner
+// 2x5 and the diagonals of 8 to 4 squares), and how many of them
+// are on the board counting every rotation and reflection.
+#define NUM_PATTERN_TYPES 8
+#define NUM_PATTERNS 34
+
+// Squares of the largest pattern.
+#define MAX_PATTERN_SIZE 10
+
+// Weights of a phase of the game, for every configuration of every
+// kind of pattern (3^10 + 3^9 + 3^10 + 3^8 + ... + 3^4).
+#define PATTERN_PHASE_SIZE 147582
+
+// Value of a disc of final difference in the tables.
+#define PATTERN_DISC_VALUE 32
+
+// Header at the beginning of a file of pattern tables. It is
+// followed by the weights of every phase, from the opening to the
+// end.
+typedef struct Pattern_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_phases;
+    uint32_t phase_size;
+} Pattern_header;
+
+// Weights of the configurations of the patterns, learned from
+// games (see pattern_trainer.c). They tell how many discs black is
+// expected to win by (in units of PATTERN_DISC_VALUE).
+typedef struct Pattern_tables
+{
+    int16_t *weights;
+} Pattern_tables;
+
+// Configuration of every pattern of a position, as a number in base
+// 3 with a digit for each square of the pattern (0 for empty, 1 for
+// black and 2 for white).
+typedef struct Pattern_indices
+{
+    int indices[NUM_PATTERNS];
+} Pattern_indices;
+
+void init_patterns(void);
+int load_pattern_tables(Pattern_tables *tables, const char *path);
+void free_pattern_tables(Pattern_tables *tables);
+void compute_pattern_indices(
+        Bitboard black, Bitboard white, Pattern_indices *indices);
+void update_pattern_indices(
+        Pattern_indices *indices, int square, Bitboard flipped,
+        char white_moved);
+void restore_pattern_indices(
+        Pattern_indices *indices, int square, Bitboard flipped,
+        char white_moved);
+int get_pattern_offset(const Pattern_indices *indices, int pattern);
+int evaluate_patterns(
+        const Pattern_tables *tables, const Pattern_indices *indices,
+        int empties);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef _REVERSI_
+#define _REVERSI_
+
+// Public header of libreversi, the engine library built with
+// "make lib" (libreversi.a and libreversi.so). It has the rules of
+// the game and the search, and doesn't depend on GTK, so programs
+// that only play or analyse positions can link it without a
+// display.
+//
+// Typical use:
+//
+//     Search_options options = {
+//         64, DEFAULT_MOVE_TIME, 0, 1, DEFAULT_ENDGAME_EMPTIES, NULL, 0,
+//         NULL, NULL, NULL, ENGINE_ALPHA_BETA, 0, NULL
+//     };
+//     Search_result result;
+//
+//     init_bitboard();
+//     init_search(&options);
+//     search_position(&position, is_max, &result);
+//
+// Positions are stored relative to the side to move, and is_max
+// tells whether the side to move is white (the maximizer).
+
+#include "bitboard/bitboard.h"
+#include "minimax/minimax.h"
+#include "minimax/evaluation.h"
+#include "minimax/probcut.h"
+#include "patterns/patterns.h"
+#include "nnue/nnue.h"
+#include "mcts/mcts.h"
+#include "minimax/endgame.h"
+#include "book/book.h"
+
+#endif
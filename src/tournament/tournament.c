@@ -0,0 +1,895 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "../reversi.h"
+
+// Default number of games of a tournament.
+#define DEFAULT_GAMES 1000
+
+// Default number of random moves that open every game.
+#define DEFAULT_OPENING_PLIES 8
+
+// Default size of the transposition table (or MCTS tree) of every
+// player, in megabytes. It's only cleared at the start of a game,
+// but the moves are short.
+#define DEFAULT_WORKER_HASH_SIZE 16
+
+// Default time budget of every move, in seconds.
+#define DEFAULT_TOURNAMENT_MOVE_TIME 0.1
+
+// Maximum number of workers.
+#define MAX_WORKERS 256
+
+// Error probabilities of the SPRT (false positive and false
+// negative).
+#define SPRT_ALPHA 0.05
+#define SPRT_BETA 0.05
+
+// How often the score so far is printed, in games.
+#define PROGRESS_INTERVAL 100
+
+// Settings of the tournament. The engine plays as "A" with the
+// first settings and as "B" with the second ones.
+typedef struct Tournament
+{
+    Search_options sides[2];
+
+    // Weights of the evaluation of each side read from a file, and
+    // the file (NULL for the default weights).
+    Evaluation_weights weights[2];
+    const char *weights_paths[2];
+
+    // Pattern tables of each side, and their file (NULL to evaluate
+    // with the weights).
+    Pattern_tables patterns[2];
+    const char *patterns_paths[2];
+
+    // Network of each side, and its file (NULL to evaluate without
+    // one).
+    Nnue_network networks[2];
+    const char *network_paths[2];
+
+    // Calibration of ProbCut of each side, and its file (NULL to
+    // search without it).
+    Probcut_parameters probcut[2];
+    const char *probcut_paths[2];
+
+    int num_games;
+    int num_workers;
+    int opening_plies;
+    unsigned long seed;
+
+    // Hypotheses of the SPRT, in Elo (when use_sprt is set).
+    char use_sprt;
+    double elo0;
+    double elo1;
+} Tournament;
+
+// Result of a game, sent by a worker to the tournament.
+typedef struct Game_result
+{
+    int worker;
+    int game;
+
+    // Final disc difference, from the point of view of A.
+    int difference;
+} Game_result;
+
+// A position that a game asks the player of one side to move in.
+typedef struct Move_request
+{
+    Position position;
+    char is_max;
+
+    // Whether the position is the first one of the side in a game,
+    // so that the player forgets what it searched in the last one.
+    char new_game;
+} Move_request;
+
+// Process that plays the moves of one side for a worker, and the
+// pipes of the requests it gets and of the moves it answers.
+typedef struct Player
+{
+    pid_t pid;
+    int request_fd;
+    int move_fd;
+} Player;
+
+// Wins, draws and losses of A.
+typedef struct Score
+{
+    int wins;
+    int draws;
+    int losses;
+} Score;
+
+static int parse_arguments(int argc, char **argv, Tournament *tournament);
+static int run_tournament(const Tournament *tournament, Score *score);
+static void run_worker(
+        const Tournament *tournament, int id, int task_fd, int result_fd);
+static int start_players(
+        const Tournament *tournament, Player players[2], int task_fd,
+        int result_fd);
+static void stop_players(Player players[2], int num_players);
+static void run_player(
+        const Tournament *tournament, int side, int request_fd, int move_fd);
+static int play_game(
+        const Tournament *tournament, Player players[2], int game,
+        int *difference);
+static void play_opening(
+        Position *position, char *is_max, int num_plies, uint64_t seed);
+static uint64_t next_random(uint64_t *state);
+static void add_result(Score *score, int difference);
+static int get_games(const Score *score);
+static double get_mean(const Score *score);
+static double get_variance(const Score *score);
+static double get_elo(double mean);
+static double get_expected_score(double elo);
+static double get_llr(const Score *score, double elo0, double elo1);
+static int get_sprt_verdict(const Tournament *tournament, const Score *score);
+static void print_score(const Score *score);
+static void print_report(const Tournament *tournament, const Score *score);
+
+
+// Plays a tournament between two settings of the engine, with
+// many games at once (one per worker process, with a process for
+// each side), and prints the
+// wins, draws and losses, the Elo difference and, if requested,
+// the verdict of a sequential probability ratio test (SPRT).
+//
+// Every opening (a few random moves from the start) is played
+// twice, with A as black and then as white.
+//
+// Usage: tournament [OPTION]...
+//
+// Options:
+// --games=N            Number of games (rounded up to an even
+//                      number).
+// --workers=N          Number of games played at once (by default,
+//                      the number of processors).
+// --opening-plies=N    Random moves that open every game.
+// --seed=N             Seed of the random openings.
+// --hash-size=MB       Transposition table of every player.
+// --a-time=SECONDS     Time budget of every move of A (and
+// --b-time=SECONDS     likewise for B).
+// --a-depth=N          Maximum depth of the search of A (0 for no
+// --b-depth=N          limit but the time).
+// --a-endgame-empties=N
+// --b-endgame-empties=N
+//                      Empty squares from which the side solves
+//                      the game to the end.
+// --a-weights=FILE     Weights of the evaluation of A (and likewise
+// --b-weights=FILE     for B; see src/minimax/weights.txt).
+// --a-patterns=FILE    Pattern tables of A (and likewise for B; see
+// --b-patterns=FILE    src/patterns/pattern_trainer.c).
+// --a-nnue=FILE        Network of A (and likewise for B; see
+// --b-nnue=FILE        src/nnue/nnue_trainer.c).
+// --a-probcut=FILE     Calibration of ProbCut of A (and likewise for
+// --b-probcut=FILE     B; see src/minimax/probcut_calibrator.c).
+// --a-engine=NAME      Engine of A before the endgame: alpha-beta
+// --b-engine=NAME      (the default) or mcts (and likewise for B).
+// --a-playouts=N       Maximum number of playouts of every move of A
+// --b-playouts=N       with MCTS (and likewise for B).
+// --sprt=ELO0,ELO1     Stop as soon as the SPRT tells whether A is
+//                      ELO0 or ELO1 stronger than B.
+int main(int argc, char **argv)
+{
+    Tournament tournament;
+    Score score = { 0, 0, 0 };
+
+    if (!parse_arguments(argc, argv, &tournament))
+    {
+        fprintf(stderr, "Usage: %s [OPTION]...\n", argv[0]);
+        fprintf(stderr, "See src/tournament/tournament.c for the options.\n");
+        return 1;
+    }
+
+    init_bitboard();
+
+    printf(
+            "%d games, %d workers, %d opening plies, seed %lu\n",
+            tournament.num_games, tournament.num_workers,
+            tournament.opening_plies, tournament.seed);
+    for (int i = 0; i < 2; i++)
+    {
+        const Search_options *side = &tournament.sides[i];
+
+        if (side->engine == ENGINE_MCTS && side->max_playouts > 0)
+            printf("%c: MCTS, %ld playouts", 'A' + i, side->max_playouts);
+        else if (side->engine == ENGINE_MCTS)
+            printf(
+                    "%c: MCTS, %.3f s per move", 'A' + i, side->move_time);
+        else if (side->max_depth > 0)
+            printf("%c: depth %d", 'A' + i, side->max_depth);
+        else
+            printf("%c: %.3f s per move", 'A' + i, side->move_time);
+        printf(", endgame at %d empties", side->endgame_empties);
+        if (tournament.weights_paths[i])
+            printf(", weights %s", tournament.weights_paths[i]);
+        if (tournament.patterns_paths[i])
+            printf(", patterns %s", tournament.patterns_paths[i]);
+        if (tournament.network_paths[i])
+            printf(", network %s", tournament.network_paths[i]);
+        if (tournament.probcut_paths[i])
+            printf(", ProbCut %s", tournament.probcut_paths[i]);
+        printf("\n");
+    }
+
+    if (!run_tournament(&tournament, &score))
+    {
+        fprintf(stderr, "Could not start the workers.\n");
+        return 1;
+    }
+    print_report(&tournament, &score);
+    return 0;
+}
+
+
+// Reads the settings of the tournament from the command line.
+//
+// Returns 1 on success and 0 if an argument isn't valid.
+static int parse_arguments(int argc, char **argv, Tournament *tournament)
+{
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+    // Default settings.
+    for (int i = 0; i < 2; i++)
+    {
+        Search_options *side = &tournament->sides[i];
+
+        side->hash_size = DEFAULT_WORKER_HASH_SIZE;
+        side->move_time = DEFAULT_TOURNAMENT_MOVE_TIME;
+        side->max_depth = 0;
+        side->threads = 1;
+        side->endgame_empties = DEFAULT_ENDGAME_EMPTIES;
+        side->book_path = NULL;
+        side->ponder = FALSE;
+        side->weights = NULL;
+        tournament->weights_paths[i] = NULL;
+        side->patterns = NULL;
+        tournament->patterns_paths[i] = NULL;
+        side->network = NULL;
+        tournament->network_paths[i] = NULL;
+        side->probcut = NULL;
+        tournament->probcut_paths[i] = NULL;
+        side->engine = ENGINE_ALPHA_BETA;
+        side->max_playouts = 0;
+    }
+    tournament->num_games = DEFAULT_GAMES;
+    tournament->num_workers = processors > 0 ? processors : 1;
+    tournament->opening_plies = DEFAULT_OPENING_PLIES;
+    tournament->seed = 1;
+    tournament->use_sprt = FALSE;
+
+    for (int i = 1; i < argc; i++)
+    {
+        int value;
+        unsigned long seed;
+        double seconds;
+        char name;
+        int path_start = 0;
+        long playouts;
+        char engine_name[16];
+
+        if (sscanf(argv[i], "--games=%d", &value) == 1 && value > 0)
+            tournament->num_games = value + value % 2;
+        else if (sscanf(argv[i], "--workers=%d", &value) == 1 && value > 0)
+            tournament->num_workers = value;
+        else if (
+                sscanf(argv[i], "--opening-plies=%d", &value) == 1 &&
+                value >= 0)
+            tournament->opening_plies = value;
+        else if (sscanf(argv[i], "--seed=%lu", &seed) == 1)
+            tournament->seed = seed;
+        else if (
+                sscanf(argv[i], "--hash-size=%d", &value) == 1 &&
+                value > 0)
+            tournament->sides[0].hash_size =
+                tournament->sides[1].hash_size = value;
+        else if (
+                sscanf(
+                    argv[i], "--sprt=%lf,%lf",
+                    &tournament->elo0, &tournament->elo1) == 2 &&
+                tournament->elo0 < tournament->elo1)
+            tournament->use_sprt = TRUE;
+
+        // Settings of one side.
+        else if (
+                sscanf(argv[i], "--%c-time=%lf", &name, &seconds) == 2 &&
+                (name == 'a' || name == 'b') && seconds > 0)
+            tournament->sides[name - 'a'].move_time = seconds;
+        else if (
+                sscanf(argv[i], "--%c-depth=%d", &name, &value) == 2 &&
+                (name == 'a' || name == 'b') && value >= 0)
+        {
+            // With a fixed depth, the time doesn't limit the search.
+            tournament->sides[name - 'a'].max_depth = value;
+            if (value > 0)
+                tournament->sides[name - 'a'].move_time = DBL_MAX;
+        }
+        else if (
+                sscanf(
+                    argv[i], "--%c-endgame-empties=%d",
+                    &name, &value) == 2 &&
+                (name == 'a' || name == 'b') && value >= 0)
+            tournament->sides[name - 'a'].endgame_empties = value;
+        else if (
+                sscanf(
+                    argv[i], "--%c-engine=%15s", &name, engine_name) == 2 &&
+                (name == 'a' || name == 'b') &&
+                (!strcmp(engine_name, "alpha-beta") ||
+                 !strcmp(engine_name, "mcts")))
+            tournament->sides[name - 'a'].engine =
+                strcmp(engine_name, "mcts") ? ENGINE_ALPHA_BETA : ENGINE_MCTS;
+        else if (
+                sscanf(argv[i], "--%c-playouts=%ld", &name, &playouts) == 2 &&
+                (name == 'a' || name == 'b') && playouts >= 0)
+        {
+            // With a number of playouts, the time doesn't limit the
+            // search.
+            tournament->sides[name - 'a'].max_playouts = playouts;
+            if (playouts > 0)
+                tournament->sides[name - 'a'].move_time = DBL_MAX;
+        }
+        else if (
+                sscanf(
+                    argv[i], "--%c-weights=%n", &name, &path_start) == 1 &&
+                path_start > 0 && (name == 'a' || name == 'b'))
+        {
+            const char *path = argv[i] + path_start;
+            int side = name - 'a';
+
+            if (!load_weights(path, &tournament->weights[side]))
+            {
+                fprintf(stderr, "Could not read the weights %s.\n", path);
+                return 0;
+            }
+            tournament->sides[side].weights = &tournament->weights[side];
+            tournament->weights_paths[side] = path;
+        }
+        else if (
+                sscanf(
+                    argv[i], "--%c-patterns=%n", &name, &path_start) == 1 &&
+                path_start > 0 && (name == 'a' || name == 'b'))
+        {
+            const char *path = argv[i] + path_start;
+            int side = name - 'a';
+
+            if (!load_pattern_tables(&tournament->patterns[side], path))
+            {
+                fprintf(
+                        stderr, "Could not read the pattern tables %s.\n",
+                        path);
+                return 0;
+            }
+            tournament->sides[side].patterns = &tournament->patterns[side];
+            tournament->patterns_paths[side] = path;
+        }
+        else if (
+                sscanf(argv[i], "--%c-nnue=%n", &name, &path_start) == 1 &&
+                path_start > 0 && (name == 'a' || name == 'b'))
+        {
+            const char *path = argv[i] + path_start;
+            int side = name - 'a';
+
+            if (!load_network(&tournament->networks[side], path))
+            {
+                fprintf(stderr, "Could not read the network %s.\n", path);
+                return 0;
+            }
+            tournament->sides[side].network = &tournament->networks[side];
+            tournament->network_paths[side] = path;
+        }
+        else if (
+                sscanf(argv[i], "--%c-probcut=%n", &name, &path_start) == 1 &&
+                path_start > 0 && (name == 'a' || name == 'b'))
+        {
+            const char *path = argv[i] + path_start;
+            int side = name - 'a';
+
+            if (!load_probcut_parameters(path, &tournament->probcut[side]))
+            {
+                fprintf(
+                        stderr, "Could not read the calibration %s.\n",
+                        path);
+                return 0;
+            }
+            tournament->sides[side].probcut = &tournament->probcut[side];
+            tournament->probcut_paths[side] = path;
+        }
+        else
+            return 0;
+    }
+
+    if (tournament->num_workers > MAX_WORKERS)
+        tournament->num_workers = MAX_WORKERS;
+    if (tournament->num_workers > tournament->num_games)
+        tournament->num_workers = tournament->num_games;
+    return 1;
+}
+
+
+// Plays the games of the tournament.
+//
+// The engine keeps its state in global variables, so the games
+// that are played at once run in worker processes, not threads,
+// and every worker has a player process for each side (see
+// run_player()). Every worker gets the number of a game through a
+// pipe of its own, plays it and writes the result to a pipe shared
+// by all the workers (writes that small are atomic). A worker that
+// sends a result gets the next game, until there are no more games
+// or the SPRT has a verdict.
+//
+// Returns 1 on success and 0 if the workers couldn't be started.
+static int run_tournament(const Tournament *tournament, Score *score)
+{
+    int task_fds[MAX_WORKERS];
+    pid_t workers[MAX_WORKERS];
+    int result_pipe[2];
+    int next_game = 0;
+    int running = 0;
+
+    if (pipe(result_pipe) < 0)
+        return 0;
+
+    // Start the workers, each one with its first game.
+    fflush(stdout);
+    for (int i = 0; i < tournament->num_workers; i++)
+    {
+        int task_pipe[2];
+
+        if (pipe(task_pipe) < 0)
+            return 0;
+        workers[i] = fork();
+        if (workers[i] < 0)
+            return 0;
+
+        if (workers[i] == 0)
+        {
+            close(task_pipe[1]);
+            close(result_pipe[0]);
+            for (int j = 0; j < i; j++)
+                close(task_fds[j]);
+            run_worker(tournament, i, task_pipe[0], result_pipe[1]);
+            _exit(0);
+        }
+
+        close(task_pipe[0]);
+        task_fds[i] = task_pipe[1];
+        if (write(task_fds[i], &next_game, sizeof(int)) == sizeof(int))
+        {
+            next_game++;
+            running++;
+        }
+    }
+    close(result_pipe[1]);
+
+    // Collect the results, and hand out the remaining games.
+    while (running > 0)
+    {
+        Game_result result;
+
+        if (
+                read(result_pipe[0], &result, sizeof(Game_result)) !=
+                sizeof(Game_result))
+            break;
+        running--;
+        add_result(score, result.difference);
+
+        if (get_games(score) % PROGRESS_INTERVAL == 0)
+            print_score(score);
+
+        // Stop handing out games when the SPRT is over.
+        if (
+                next_game < tournament->num_games &&
+                !get_sprt_verdict(tournament, score) &&
+                write(
+                    task_fds[result.worker], &next_game, sizeof(int)) ==
+                sizeof(int))
+        {
+            next_game++;
+            running++;
+        }
+    }
+
+    // Closing the pipes of the tasks makes the workers finish.
+    for (int i = 0; i < tournament->num_workers; i++)
+        close(task_fds[i]);
+    for (int i = 0; i < tournament->num_workers; i++)
+        waitpid(workers[i], NULL, 0);
+    close(result_pipe[0]);
+    return 1;
+}
+
+
+// Body of a worker process: plays the games it gets until the
+// pipe of the tasks is closed.
+static void run_worker(
+        const Tournament *tournament, int id, int task_fd, int result_fd)
+{
+    Player players[2];
+    Game_result result;
+
+    if (!start_players(tournament, players, task_fd, result_fd))
+    {
+        fprintf(stderr, "Worker %d: could not start the players.\n", id);
+        return;
+    }
+
+    result.worker = id;
+    while (read(task_fd, &result.game, sizeof(int)) == sizeof(int))
+    {
+        if (!play_game(tournament, players, result.game, &result.difference))
+        {
+            fprintf(stderr, "Worker %d: a player stopped.\n", id);
+            break;
+        }
+        if (
+                write(result_fd, &result, sizeof(Game_result)) !=
+                sizeof(Game_result))
+            break;
+    }
+    stop_players(players, 2);
+}
+
+
+// Starts the player processes of a worker, A and then B.
+//
+// Arguments:
+// The tournament.
+// The players to start.
+// The pipes of the worker, which the players don't use.
+//
+// Returns 1 on success and 0 if a player couldn't be started (the
+// ones that were are stopped).
+static int start_players(
+        const Tournament *tournament, Player players[2], int task_fd,
+        int result_fd)
+{
+    for (int side = 0; side < 2; side++)
+    {
+        int request_pipe[2];
+        int move_pipe[2];
+
+        if (pipe(request_pipe) < 0)
+        {
+            stop_players(players, side);
+            return 0;
+        }
+        if (pipe(move_pipe) < 0)
+        {
+            close(request_pipe[0]);
+            close(request_pipe[1]);
+            stop_players(players, side);
+            return 0;
+        }
+
+        players[side].pid = fork();
+        if (players[side].pid < 0)
+        {
+            close(request_pipe[0]);
+            close(request_pipe[1]);
+            close(move_pipe[0]);
+            close(move_pipe[1]);
+            stop_players(players, side);
+            return 0;
+        }
+
+        if (players[side].pid == 0)
+        {
+            // A player must not keep the pipes of the other one open,
+            // or it wouldn't see them closed.
+            close(request_pipe[1]);
+            close(move_pipe[0]);
+            close(task_fd);
+            close(result_fd);
+            for (int j = 0; j < side; j++)
+            {
+                close(players[j].request_fd);
+                close(players[j].move_fd);
+            }
+            run_player(tournament, side, request_pipe[0], move_pipe[1]);
+            _exit(0);
+        }
+
+        close(request_pipe[0]);
+        close(move_pipe[1]);
+        players[side].request_fd = request_pipe[1];
+        players[side].move_fd = move_pipe[0];
+    }
+    return 1;
+}
+
+
+// Closes the pipes of the first players, which makes them finish,
+// and waits for them.
+static void stop_players(Player players[2], int num_players)
+{
+    for (int i = 0; i < num_players; i++)
+    {
+        close(players[i].request_fd);
+        close(players[i].move_fd);
+    }
+    for (int i = 0; i < num_players; i++)
+        waitpid(players[i].pid, NULL, 0);
+}
+
+
+// Body of a player process: searches the positions it gets with
+// the settings of its side, and answers the square of the move,
+// until the pipe of the requests is closed.
+//
+// The search keeps its state (the transposition table, the move
+// ordering and the MCTS tree) from one move to the next one of the
+// same game, and the side never sees what the other one searched.
+static void run_player(
+        const Tournament *tournament, int side, int request_fd, int move_fd)
+{
+    Move_request request;
+    Search_result result;
+
+    if (!init_search(&tournament->sides[side]))
+    {
+        fprintf(stderr, "Player %c: out of memory.\n", 'A' + side);
+        return;
+    }
+
+    while (
+            read(request_fd, &request, sizeof(Move_request)) ==
+            sizeof(Move_request))
+    {
+        if (request.new_game)
+            clear_search();
+        search_position(&request.position, request.is_max, &result);
+        if (
+                write(move_fd, &result.square, sizeof(int)) !=
+                sizeof(int))
+            break;
+    }
+}
+
+
+// Plays a game of the tournament. Games 2n and 2n + 1 start with
+// the same opening, with A as black in the first one and as white
+// in the second one.
+//
+// Arguments:
+// The tournament.
+// The players of A and B.
+// The number of the game.
+// A variable to store the final disc difference, from the point of
+// view of A.
+//
+// Returns 1 on success and 0 if a player stopped answering.
+static int play_game(
+        const Tournament *tournament, Player players[2], int game,
+        int *difference)
+{
+    Move_request request;
+    char a_is_white = game % 2;
+    char started[2] = { FALSE, FALSE };
+
+    play_opening(
+            &request.position, &request.is_max, tournament->opening_plies,
+            tournament->seed * 1000003 + game / 2);
+
+    for (;;)
+    {
+        Position *position = &request.position;
+        int square;
+
+        // A player without valid moves passes. When neither player
+        // has valid moves, the game is over.
+        if (!get_valid_moves(position))
+        {
+            pass_turn(position);
+            request.is_max = !request.is_max;
+            if (!get_valid_moves(position))
+                break;
+        }
+
+        // White is the maximizer.
+        int side = request.is_max != a_is_white;
+        request.new_game = !started[side];
+        started[side] = TRUE;
+        if (
+                write(
+                    players[side].request_fd, &request,
+                    sizeof(Move_request)) != sizeof(Move_request) ||
+                read(players[side].move_fd, &square, sizeof(int)) !=
+                sizeof(int))
+            return 0;
+
+        play_move(position, square);
+        request.is_max = !request.is_max;
+    }
+
+    const Position *position = &request.position;
+    int discs =
+        count_discs(position->player) - count_discs(position->opponent);
+    *difference = request.is_max == a_is_white ? discs : -discs;
+    return 1;
+}
+
+
+// Plays random moves from the start of the game.
+//
+// Arguments:
+// A position to store the result, and whether the side to move is
+// the maximizer (white).
+// The number of moves and the seed of the random numbers.
+static void play_opening(
+        Position *position, char *is_max, int num_plies, uint64_t seed)
+{
+    uint64_t state = seed + 1;
+
+    set_start_position(position);
+    *is_max = 0;
+
+    for (int i = 0; i < num_plies; i++)
+    {
+        Bitboard moves = get_valid_moves(position);
+        if (!moves)
+            break;
+
+        // Pick one of the valid moves.
+        int index = next_random(&state) % count_discs(moves);
+        int square = pop_first_square(&moves);
+        while (index-- > 0)
+            square = pop_first_square(&moves);
+
+        play_move(position, square);
+        *is_max = !*is_max;
+    }
+}
+
+
+// Returns the next number of a xorshift generator.
+static uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+
+// Counts the result of a game, given its disc difference.
+static void add_result(Score *score, int difference)
+{
+    if (difference > 0)
+        score->wins++;
+    else if (difference < 0)
+        score->losses++;
+    else
+        score->draws++;
+}
+
+
+// Returns the number of games played.
+static int get_games(const Score *score)
+{
+    return score->wins + score->draws + score->losses;
+}
+
+
+// Returns the average score of A per game (1 for a win, 1/2 for a
+// draw and 0 for a loss).
+static double get_mean(const Score *score)
+{
+    return (score->wins + 0.5 * score->draws) / get_games(score);
+}
+
+
+// Returns the variance of the score of A in a game.
+static double get_variance(const Score *score)
+{
+    double mean = get_mean(score);
+
+    return (score->wins * (1 - mean) * (1 - mean) +
+            score->draws * (0.5 - mean) * (0.5 - mean) +
+            score->losses * mean * mean) / get_games(score);
+}
+
+
+// Returns the Elo difference that gives an expected score.
+static double get_elo(double mean)
+{
+    return -400 * log10(1 / mean - 1);
+}
+
+
+// Returns the expected score of a player that is the given Elo
+// difference stronger than its opponent.
+static double get_expected_score(double elo)
+{
+    return 1 / (1 + pow(10, -elo / 400));
+}
+
+
+// Returns the log-likelihood ratio of the hypotheses "A is elo1
+// stronger than B" and "A is elo0 stronger than B", with the
+// normal approximation of the average score.
+static double get_llr(const Score *score, double elo0, double elo1)
+{
+    double variance = get_variance(score);
+    double score0 = get_expected_score(elo0);
+    double score1 = get_expected_score(elo1);
+
+    if (variance <= 0)
+        return 0;
+    return
+        get_games(score) * (score1 - score0) *
+        (2 * get_mean(score) - score0 - score1) / (2 * variance);
+}
+
+
+// Returns the verdict of the SPRT: 1 if it accepts elo1, -1 if it
+// accepts elo0 and 0 if it needs more games (or there's no SPRT).
+static int get_sprt_verdict(const Tournament *tournament, const Score *score)
+{
+    if (!tournament->use_sprt)
+        return 0;
+
+    double llr = get_llr(score, tournament->elo0, tournament->elo1);
+
+    if (llr >= log((1 - SPRT_BETA) / SPRT_ALPHA))
+        return 1;
+    if (llr <= log(SPRT_BETA / (1 - SPRT_ALPHA)))
+        return -1;
+    return 0;
+}
+
+
+// Prints the wins, draws and losses of A so far.
+static void print_score(const Score *score)
+{
+    printf(
+            "Games %d: +%d =%d -%d (%.1f%%)\n",
+            get_games(score), score->wins, score->draws, score->losses,
+            100 * get_mean(score));
+    fflush(stdout);
+}
+
+
+// Prints the final score, the Elo difference between A and B with
+// its 95% confidence interval, and the result of the SPRT.
+static void print_report(const Tournament *tournament, const Score *score)
+{
+    if (get_games(score) == 0)
+        return;
+
+    print_score(score);
+
+    // Confidence interval of the average score, converted to Elo.
+    double mean = get_mean(score);
+    double error = 1.96 * sqrt(get_variance(score) / get_games(score));
+    if (mean <= 0 || mean >= 1)
+        printf("Elo difference: %s\n", mean <= 0 ? "-inf" : "+inf");
+    else
+    {
+        double low = mean - error > 0 ? get_elo(mean - error) : -INFINITY;
+        double high = mean + error < 1 ? get_elo(mean + error) : INFINITY;
+        printf(
+                "Elo difference: %+.1f +/- %.1f (95%%: %+.1f to %+.1f)\n",
+                get_elo(mean), (high - low) / 2, low, high);
+    }
+
+    if (tournament->use_sprt)
+    {
+        int verdict = get_sprt_verdict(tournament, score);
+
+        printf(
+                "SPRT (%+.1f, %+.1f): LLR %.2f (%.2f, %.2f), %s\n",
+                tournament->elo0, tournament->elo1,
+                get_llr(score, tournament->elo0, tournament->elo1),
+                log(SPRT_BETA / (1 - SPRT_ALPHA)),
+                log((1 - SPRT_BETA) / SPRT_ALPHA),
+                verdict > 0 ? "H1 accepted" :
+                verdict < 0 ? "H0 accepted" : "inconclusive");
+    }
+}